@@ -0,0 +1,136 @@
+#include "Common/ShaderTestFrameGraph.h"
+#include "Common/ShaderTestReadback.h"
+#include "Common/ShaderTestPassProfiler.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderingThread.h"
+#include "SceneViewExtension.h"
+#include "Misc/CoreDelegates.h"
+
+
+static TAutoConsoleVariable<int32> CVarShaderTestFrameGraph(
+	TEXT("r.ShaderTest.FrameGraph"),
+	1,
+	TEXT("1: the plugin RDG passes of a frame share one graph executed before the views render (default).\n")
+	TEXT("0: every call executes its own graph."),
+	ECVF_RenderThreadSafe);
+
+/** Render thread only. */
+static TArray<FShaderTestFrameGraph::FAddPassesFunction> GPendingAddPasses;
+
+static FDelegateHandle GEndFrameHandle;
+static FDelegateHandle GPostEngineInitHandle;
+
+
+/** Flushes the frame graph before every view family renders, so the materials of the frame sample the targets drawn this frame. */
+class FShaderTestFrameGraphViewExtension : public FSceneViewExtensionBase
+{
+public:
+	FShaderTestFrameGraphViewExtension(const FAutoRegister& AutoRegister)
+		: FSceneViewExtensionBase(AutoRegister)
+	{ }
+
+	// ISceneViewExtension interface.
+	virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override { }
+	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override { }
+	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override { }
+	virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override { }
+
+	virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override
+	{
+		FShaderTestFrameGraph::Flush(RHICmdList);
+	}
+};
+
+/** Game thread, registered once the engine is initialized. */
+static TSharedPtr<FShaderTestFrameGraphViewExtension, ESPMode::ThreadSafe> GFrameGraphViewExtension;
+
+
+void FShaderTestFrameGraph::AddPasses(FRHICommandListImmediate& RHICmdList, FAddPassesFunction&& AddPassesFunction)
+{
+	check(IsInRenderingThread());
+
+	if (CVarShaderTestFrameGraph.GetValueOnRenderThread())
+	{
+		GPendingAddPasses.Add(MoveTemp(AddPassesFunction));
+		return;
+	}
+
+	// Keeps the order with the calls queued before the cvar changed.
+	Flush(RHICmdList);
+
+	FRDGBuilder GraphBuilder(RHICmdList);
+	AddPassesFunction(GraphBuilder);
+	GraphBuilder.Execute();
+}
+
+
+void FShaderTestFrameGraph::Flush(FRHICommandListImmediate& RHICmdList)
+{
+	check(IsInRenderingThread());
+
+	if (GPendingAddPasses.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FAddPassesFunction> PendingAddPasses = MoveTemp(GPendingAddPasses);
+
+	FRDGBuilder GraphBuilder(RHICmdList, RDG_EVENT_NAME("ShaderTest %d calls", PendingAddPasses.Num()));
+	for (FAddPassesFunction& AddPassesFunction : PendingAddPasses)
+	{
+		AddPassesFunction(GraphBuilder);
+	}
+	GraphBuilder.Execute();
+}
+
+
+void FShaderTestFrameGraph::EnqueueFlush()
+{
+	check(IsInGameThread());
+
+	ENQUEUE_RENDER_COMMAND(ShaderTestFlushFrameGraph)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			Flush(RHICmdList);
+		});
+}
+
+
+void FShaderTestFrameGraph::Startup()
+{
+	GPostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddStatic([]()
+	{
+		GFrameGraphViewExtension = FSceneViewExtensions::NewExtension<FShaderTestFrameGraphViewExtension>();
+	});
+
+	GEndFrameHandle = FCoreDelegates::OnEndFrameRT.AddStatic([]()
+	{
+		// Only has passes on the frames without a view family, or for the calls enqueued after the views.
+		FRHICommandListImmediate& RHICmdList = FRHICommandListExecutor::GetImmediateCommandList();
+		Flush(RHICmdList);
+
+		// The copies of the readbacks are queued by the flush.
+		FShaderTestReadback::Poll(RHICmdList);
+
+		FShaderTestPassProfiler::EndFrameRenderThread();
+	});
+}
+
+
+void FShaderTestFrameGraph::Shutdown()
+{
+	FCoreDelegates::OnPostEngineInit.Remove(GPostEngineInitHandle);
+	FCoreDelegates::OnEndFrameRT.Remove(GEndFrameHandle);
+
+	// Drops the references held by the calls never flushed.
+	ENQUEUE_RENDER_COMMAND(ShaderTestDiscardFrameGraph)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			GPendingAddPasses.Empty();
+		});
+	FlushRenderingCommands();
+
+	// After the flush, the render thread no longer references the extension.
+	GFrameGraphViewExtension.Reset();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphDefinitions.h"
+
+class FRHICommandListImmediate;
+
+
+/**
+ * Render thread accumulator of the plugin RDG passes. The entry points append their passes to one graph per frame,
+ * set up and executed before the view families render, so that their materials sample this frame's targets, and RDG culls,
+ * merges the render passes and batches the barriers across calls. The end of frame flushes the frames without views.
+ *
+ * r.ShaderTest.FrameGraph 0 executes a graph per call instead.
+ */
+class FShaderTestFrameGraph
+{
+public:
+	/** Adds the passes of one call, the function runs at flush time and must own everything it references. */
+	using FAddPassesFunction = TUniqueFunction<void(FRDGBuilder& GraphBuilder)>;
+
+	/** Render thread. Queues the passes into the frame graph, or executes them right away when it is disabled. */
+	static void AddPasses(FRHICommandListImmediate& RHICmdList, FAddPassesFunction&& AddPassesFunction);
+
+	/** Render thread. Executes the passes queued so far, for the work reading or writing the same targets outside of the graph. */
+	static void Flush(FRHICommandListImmediate& RHICmdList);
+
+	/** Game thread. Enqueues a Flush() ahead of the render commands enqueued next. */
+	static void EnqueueFlush();
+
+	/** Hooks the view family and end of frame flushes, called by the module. */
+	static void Startup();
+	static void Shutdown();
+};
@@ -0,0 +1,226 @@
+#include "Common/ShaderTestPSOPrecache.h"
+
+#include "CommonRenderResources.h"
+#include "GlobalShader.h"
+#include "PipelineStateCache.h"
+#include "RenderingThread.h"
+#include "RenderUtils.h"
+#include "RHIStaticStates.h"
+#include "Misc/CoreDelegates.h"
+
+
+static TAutoConsoleVariable<int32> CVarShaderTestPrecachePSOs(
+	TEXT("r.ShaderTest.PrecachePSOs"),
+	0,
+	TEXT("1: requests the pipeline states of every plugin global shader permutation from the pipeline state cache after the engine init.\n")
+	TEXT("They compile on the cache tasks with r.AsyncPipelineCompile, on the render thread otherwise, so the logged time only covers the\n")
+	TEXT("compiles in the latter case."),
+	ECVF_ReadOnly);
+
+/** Formats of the render targets the plugin usually draws to: RTF_RGBA8, RTF_RGBA16f and RTF_RGBA32f. */
+static const EPixelFormat kPrecacheRenderTargetFormats[] = { PF_B8G8R8A8, PF_FloatRGBA, PF_A32B32G32R32F };
+
+static const TCHAR* kPluginShaderDirectory = TEXT("/Plugin/ShaderTest/");
+
+static FDelegateHandle GPostEngineInitHandle;
+
+
+/** Render target the pipeline states are created for, the flags are part of the pipeline state cache key. */
+struct FShaderTestPrecacheRenderTarget
+{
+	EPixelFormat Format;
+	ETextureCreateFlags Flags;
+};
+
+/** The formats with the flags of the UTextureRenderTarget2D textures and of the plugin pooled textures: with or without
+ *  bCanCreateUAV, and sRGB for RTF_RGBA8 unless bForceLinearGamma.
+ */
+static TArray<FShaderTestPrecacheRenderTarget> GetPrecacheRenderTargets()
+{
+	TArray<FShaderTestPrecacheRenderTarget> RenderTargets;
+	for (EPixelFormat Format : kPrecacheRenderTargetFormats)
+	{
+		for (bool bSRGB : { false, true })
+		{
+			if (bSRGB && Format != PF_B8G8R8A8)
+			{
+				continue;
+			}
+
+			for (bool bUAV : { false, true })
+			{
+				ETextureCreateFlags Flags = TexCreate_RenderTargetable | TexCreate_ShaderResource;
+				Flags |= bSRGB ? TexCreate_SRGB : TexCreate_None;
+				Flags |= bUAV ? TexCreate_UAV : TexCreate_None;
+				RenderTargets.Add({ Format, Flags });
+			}
+		}
+	}
+	return RenderTargets;
+}
+
+
+/** Pipeline state to create, with a name for the log. */
+struct FShaderTestPSOPrecacheItem
+{
+	FString Name;
+	FGraphicsPipelineStateInitializer GraphicsInitializer;
+	FRHIComputeShader* ComputeShader = nullptr;
+};
+
+/** Vertex declaration of the vertex shaders not drawing a full screen triangle from SV_VertexID. */
+static FRHIVertexDeclaration* GetPrecacheVertexDeclaration(const FShaderType* VertexShaderType)
+{
+	if (FCString::Strcmp(VertexShaderType->GetName(), TEXT("FLensDistortionUVGenerationVS")) == 0)
+	{
+		return GetVertexDeclarationFVector4();
+	}
+	return GEmptyVertexDeclaration.VertexDeclarationRHI;
+}
+
+/** Render thread. Lists the pipeline states of the compiled plugin global shader permutations. */
+static TArray<FShaderTestPSOPrecacheItem> GatherPrecacheItems(ERHIFeatureLevel::Type FeatureLevel)
+{
+	FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+
+	struct FShaderPermutation
+	{
+		FShaderType* Type;
+		int32 PermutationId;
+		TShaderRef<FShader> Shader;
+	};
+	TMap<FString, TArray<FShaderPermutation>> ShadersByFile;
+
+	for (TLinkedList<FShaderType*>::TIterator It(FShaderType::GetTypeList()); It; It.Next())
+	{
+		FShaderType* ShaderType = *It;
+		if (!ShaderType->GetGlobalShaderType() || !FCString::Strstr(ShaderType->GetShaderFilename(), kPluginShaderDirectory))
+		{
+			continue;
+		}
+
+		for (int32 PermutationId = 0; PermutationId < ShaderType->GetPermutationCount(); PermutationId++)
+		{
+			TShaderRef<FShader> Shader = GlobalShaderMap->GetShader(ShaderType, PermutationId);
+			if (Shader.IsValid())
+			{
+				ShadersByFile.FindOrAdd(ShaderType->GetShaderFilename()).Add({ ShaderType, PermutationId, Shader });
+			}
+		}
+	}
+
+	const TArray<FShaderTestPrecacheRenderTarget> RenderTargets = GetPrecacheRenderTargets();
+
+	TArray<FShaderTestPSOPrecacheItem> Items;
+	for (const TPair<FString, TArray<FShaderPermutation>>& File : ShadersByFile)
+	{
+		for (const FShaderPermutation& Shader : File.Value)
+		{
+			if (Shader.Type->GetFrequency() == SF_Compute)
+			{
+				FShaderTestPSOPrecacheItem& Item = Items.AddDefaulted_GetRef();
+				Item.Name = FString::Printf(TEXT("%s:%d"), Shader.Type->GetName(), Shader.PermutationId);
+				Item.ComputeShader = Shader.Shader.GetComputeShader();
+				continue;
+			}
+
+			if (Shader.Type->GetFrequency() != SF_Pixel)
+			{
+				continue;
+			}
+
+			// The pixel shaders are drawn with the vertex shaders of their file, in the states of the plugin draws.
+			for (const FShaderPermutation& VertexShader : File.Value)
+			{
+				if (VertexShader.Type->GetFrequency() != SF_Vertex)
+				{
+					continue;
+				}
+
+				for (const FShaderTestPrecacheRenderTarget& RenderTarget : RenderTargets)
+				{
+					FShaderTestPSOPrecacheItem& Item = Items.AddDefaulted_GetRef();
+					Item.Name = FString::Printf(TEXT("%s:%d + %s:%d, %s%s%s"),
+						VertexShader.Type->GetName(), VertexShader.PermutationId, Shader.Type->GetName(), Shader.PermutationId, GPixelFormats[RenderTarget.Format].Name,
+						EnumHasAnyFlags(RenderTarget.Flags, TexCreate_SRGB) ? TEXT(" sRGB") : TEXT(""),
+						EnumHasAnyFlags(RenderTarget.Flags, TexCreate_UAV) ? TEXT(" UAV") : TEXT(""));
+
+					FGraphicsPipelineStateInitializer& GraphicsPSOInit = Item.GraphicsInitializer;
+					GraphicsPSOInit.RenderTargetsEnabled = 1;
+					GraphicsPSOInit.RenderTargetFormats[0] = RenderTarget.Format;
+					GraphicsPSOInit.RenderTargetFlags[0] = RenderTarget.Flags;
+					GraphicsPSOInit.NumSamples = 1;
+					GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+					GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+					GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+					GraphicsPSOInit.PrimitiveType = PT_TriangleList;
+					GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GetPrecacheVertexDeclaration(VertexShader.Type);
+					GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.Shader.GetVertexShader();
+					GraphicsPSOInit.BoundShaderState.PixelShaderRHI = Shader.Shader.GetPixelShader();
+				}
+			}
+		}
+	}
+
+	return Items;
+}
+
+/** Render thread. Creates the pipeline states through the pipeline state cache, where the first draws look them up. */
+static void CreatePrecachePipelineStates(FRHICommandListImmediate& RHICmdList, const TArray<FShaderTestPSOPrecacheItem>& Items)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	int32 NumFailed = 0;
+	for (const FShaderTestPSOPrecacheItem& Item : Items)
+	{
+		bool bCreated;
+		if (Item.ComputeShader)
+		{
+			bCreated = PipelineStateCache::GetAndOrCreateComputePipelineState(RHICmdList, Item.ComputeShader, false) != nullptr;
+		}
+		else
+		{
+			bCreated = PipelineStateCache::GetAndOrCreateGraphicsPipelineState(RHICmdList, Item.GraphicsInitializer, EApplyRendertargetOption::DoNothing) != nullptr;
+		}
+
+		// An async compile is only enqueued here, its failure is reported by the pipeline state cache.
+		if (!bCreated)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FShaderTestPSOPrecache, %s failed"), *Item.Name);
+			NumFailed++;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("FShaderTestPSOPrecache, %d pipeline states requested in %.2f ms, %d failed"),
+		Items.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0, NumFailed);
+}
+
+static void PrecachePipelineStates()
+{
+	check(IsInGameThread());
+
+	if (!CVarShaderTestPrecachePSOs.GetValueOnGameThread() || !FApp::CanEverRender())
+	{
+		return;
+	}
+
+	const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+	ENQUEUE_RENDER_COMMAND(ShaderTestPrecachePSOs)(
+		[FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			const TArray<FShaderTestPSOPrecacheItem> Items = GatherPrecacheItems(FeatureLevel);
+			CreatePrecachePipelineStates(RHICmdList, Items);
+		});
+}
+
+
+void FShaderTestPSOPrecache::Startup()
+{
+	GPostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddStatic(&PrecachePipelineStates);
+}
+
+
+void FShaderTestPSOPrecache::Shutdown()
+{
+	FCoreDelegates::OnPostEngineInit.Remove(GPostEngineInitHandle);
+}
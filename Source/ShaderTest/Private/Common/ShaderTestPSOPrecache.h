@@ -0,0 +1,19 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Opt-in warmup of the plugin pipeline states, enabled with r.ShaderTest.PrecachePSOs=1 (ini or command line).
+ *
+ * Once the engine is initialized, every permutation of the plugin global shaders is paired with the vertex shaders
+ * of the same file and the common render targets, and the pipeline states are requested from the pipeline state cache,
+ * so that the first draws find them there.
+ */
+class FShaderTestPSOPrecache
+{
+public:
+	/** Hooks the precache to the end of the engine init, called by the module. */
+	static void Startup();
+	static void Shutdown();
+};
@@ -0,0 +1,319 @@
+#include "Common/ShaderTestPassProfiler.h"
+#include "Common/MyShaderTypes.h"
+#include "ShaderTestLibrary.h"
+
+#include "RenderGraphBuilder.h"
+#include "RHICommandList.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+
+
+static const TCHAR* const GShaderTestPassNames[] =
+{
+	TEXT("FirstShader"),
+	TEXT("TextureShader"),
+	TEXT("ComputeShader"),
+	TEXT("LensDistortion"),
+	TEXT("Readback"),
+};
+static_assert(UE_ARRAY_COUNT(GShaderTestPassNames) == int32(EShaderTestPass::Num), "Missing EShaderTestPass name.");
+
+
+/** Counters of one entry point over a frame. */
+struct FShaderTestPassCounters
+{
+	uint64 CPUCycles = 0;
+	int32 NumCalls = 0;
+	double GPUMicroseconds = 0.0;
+	int32 DrawCalls = 0;
+	int64 UploadedBytes = 0;
+};
+
+/** Timestamps of one scope, waiting for the GPU. */
+struct FShaderTestPendingGPUTime
+{
+	EShaderTestPass Pass;
+	FRHIPooledRenderQuery Begin;
+	FRHIPooledRenderQuery End;
+};
+
+/** Game thread only. */
+static FShaderTestPassCounters GGameThreadCounters[int32(EShaderTestPass::Num)];
+
+/** Render thread only. */
+static FShaderTestPassCounters GRenderThreadCounters[int32(EShaderTestPass::Num)];
+static TArray<FShaderTestPendingGPUTime> GPendingGPUTimes;
+static FRenderQueryPoolRHIRef GTimestampQueryPool;
+
+/** Latest frame of each entry point, written by both threads at their end of frame. */
+static FCriticalSection GLatestStatsLock;
+static FShaderTestPassStats GLatestStats[int32(EShaderTestPass::Num)];
+
+static FDelegateHandle GEndFrameHandle;
+
+
+FShaderTestPassProfiler::FScopedCPUTime::FScopedCPUTime(EShaderTestPass InPass, EShaderTestPassThread InThread)
+	: Pass(InPass)
+	, Thread(InThread)
+	, StartCycles(FPlatformTime::Cycles64())
+{ }
+
+
+FShaderTestPassProfiler::FScopedCPUTime::~FScopedCPUTime()
+{
+	FShaderTestPassCounters& Counters = Thread == EShaderTestPassThread::GameThread ? GGameThreadCounters[int32(Pass)] : GRenderThreadCounters[int32(Pass)];
+	Counters.CPUCycles += FPlatformTime::Cycles64() - StartCycles;
+	Counters.NumCalls++;
+}
+
+
+/** Writes a timestamp between the passes of the graph. */
+static void AddTimestampPass(FRDGBuilder& GraphBuilder, FRHIRenderQuery* Query)
+{
+	GraphBuilder.AddPass(
+		RDG_EVENT_NAME("ShaderTestTimestamp"),
+		ERDGPassFlags::NeverCull,
+		[Query](FRHICommandListImmediate& RHICmdList)
+		{
+			RHICmdList.EndRenderQuery(Query);
+		});
+}
+
+
+FShaderTestPassProfiler::FRDGScopedGPUTime::FRDGScopedGPUTime(FRDGBuilder& InGraphBuilder, EShaderTestPass InPass)
+	: GraphBuilder(InGraphBuilder)
+	, Pass(InPass)
+	, Begin(AllocateTimestampQuery())
+{
+	AddTimestampPass(GraphBuilder, Begin.GetQuery());
+}
+
+
+FShaderTestPassProfiler::FRDGScopedGPUTime::~FRDGScopedGPUTime()
+{
+	// The queries outlive the graph in the pending list.
+	FRHIPooledRenderQuery End = AllocateTimestampQuery();
+	AddTimestampPass(GraphBuilder, End.GetQuery());
+	AddGPUTime(Pass, MoveTemp(Begin), MoveTemp(End));
+}
+
+
+FShaderTestPassProfiler::FRHIScopedGPUTime::FRHIScopedGPUTime(FRHICommandList& InRHICmdList, EShaderTestPass InPass)
+	: RHICmdList(InRHICmdList)
+	, Pass(InPass)
+	, Begin(AllocateTimestampQuery())
+{
+	RHICmdList.EndRenderQuery(Begin.GetQuery());
+}
+
+
+FShaderTestPassProfiler::FRHIScopedGPUTime::~FRHIScopedGPUTime()
+{
+	FRHIPooledRenderQuery End = AllocateTimestampQuery();
+	RHICmdList.EndRenderQuery(End.GetQuery());
+	AddGPUTime(Pass, MoveTemp(Begin), MoveTemp(End));
+}
+
+
+FRHIPooledRenderQuery FShaderTestPassProfiler::AllocateTimestampQuery()
+{
+	check(IsInRenderingThread());
+
+	if (!GTimestampQueryPool)
+	{
+		GTimestampQueryPool = RHICreateRenderQueryPool(RQT_AbsoluteTime);
+	}
+	return GTimestampQueryPool->AllocateQuery();
+}
+
+
+void FShaderTestPassProfiler::AddGPUTime(EShaderTestPass Pass, FRHIPooledRenderQuery&& Begin, FRHIPooledRenderQuery&& End)
+{
+	check(IsInRenderingThread());
+
+	GPendingGPUTimes.Add({ Pass, MoveTemp(Begin), MoveTemp(End) });
+}
+
+
+void FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass Pass, int32 NumDrawCalls)
+{
+	check(IsInRenderingThread());
+
+	GRenderThreadCounters[int32(Pass)].DrawCalls += NumDrawCalls;
+}
+
+
+void FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass Pass, int64 NumBytes)
+{
+	check(IsInRenderingThread());
+
+	GRenderThreadCounters[int32(Pass)].UploadedBytes += NumBytes;
+}
+
+
+#if STATS
+/** Counter stats published at the end of the frame, per entry point. */
+struct FShaderTestPassStatNames
+{
+	FName GPU;
+	FName DrawCalls;
+	FName UploadedBytes;
+};
+
+#define SHADERTEST_PASS_STAT_NAMES(Pass) \
+	{ GET_STATFNAME(STAT_ShaderTest_##Pass##_GPU), GET_STATFNAME(STAT_ShaderTest_##Pass##_DrawCalls), GET_STATFNAME(STAT_ShaderTest_##Pass##_UploadedBytes) }
+
+static const FShaderTestPassStatNames& GetShaderTestPassStatNames(EShaderTestPass Pass)
+{
+	static const FShaderTestPassStatNames StatNames[] =
+	{
+		SHADERTEST_PASS_STAT_NAMES(FirstShader),
+		SHADERTEST_PASS_STAT_NAMES(TextureShader),
+		SHADERTEST_PASS_STAT_NAMES(ComputeShader),
+		SHADERTEST_PASS_STAT_NAMES(LensDistortion),
+		SHADERTEST_PASS_STAT_NAMES(Readback),
+	};
+	static_assert(UE_ARRAY_COUNT(StatNames) == int32(EShaderTestPass::Num), "Missing EShaderTestPass stats.");
+	return StatNames[int32(Pass)];
+}
+
+#undef SHADERTEST_PASS_STAT_NAMES
+#endif
+
+
+#if CSV_PROFILER
+/** Custom stats of the CSV profiler, per entry point, the CPU scopes are timing stats. */
+struct FShaderTestPassCsvStatNames
+{
+	FName GPU;
+	FName DrawCalls;
+	FName UploadedBytes;
+};
+
+static const FShaderTestPassCsvStatNames& GetShaderTestPassCsvStatNames(EShaderTestPass Pass)
+{
+	static const TArray<FShaderTestPassCsvStatNames> CsvStatNames = []()
+	{
+		TArray<FShaderTestPassCsvStatNames> Names;
+		for (const TCHAR* PassName : GShaderTestPassNames)
+		{
+			Names.Add({
+				FName(*FString::Printf(TEXT("%s_GPU"), PassName)),
+				FName(*FString::Printf(TEXT("%s_DrawCalls"), PassName)),
+				FName(*FString::Printf(TEXT("%s_UploadedBytes"), PassName)) });
+		}
+		return Names;
+	}();
+	return CsvStatNames[int32(Pass)];
+}
+#endif
+
+
+void FShaderTestPassProfiler::EndFrameRenderThread()
+{
+	check(IsInRenderingThread());
+
+	// Reads the timestamps the GPU is done with, in submission order, without waiting.
+	int32 NumResolved = 0;
+	for (; NumResolved < GPendingGPUTimes.Num(); NumResolved++)
+	{
+		const FShaderTestPendingGPUTime& PendingGPUTime = GPendingGPUTimes[NumResolved];
+
+		// Microseconds.
+		uint64 Begin = 0;
+		uint64 End = 0;
+		if (!RHIGetRenderQueryResult(PendingGPUTime.Begin.GetQuery(), Begin, false) || !RHIGetRenderQueryResult(PendingGPUTime.End.GetQuery(), End, false))
+		{
+			break;
+		}
+		GRenderThreadCounters[int32(PendingGPUTime.Pass)].GPUMicroseconds += double(End - Begin);
+	}
+	// Returns their queries to the pool.
+	GPendingGPUTimes.RemoveAt(0, NumResolved, false);
+
+	FScopeLock Lock(&GLatestStatsLock);
+
+	for (int32 PassIndex = 0; PassIndex < int32(EShaderTestPass::Num); PassIndex++)
+	{
+		const FShaderTestPassCounters& Counters = GRenderThreadCounters[PassIndex];
+		const float GPUMs = float(Counters.GPUMicroseconds / 1000.0);
+
+#if STATS
+		const FShaderTestPassStatNames& StatNames = GetShaderTestPassStatNames(EShaderTestPass(PassIndex));
+		SET_FLOAT_STAT_FName(StatNames.GPU, GPUMs);
+		SET_DWORD_STAT_FName(StatNames.DrawCalls, Counters.DrawCalls);
+		SET_MEMORY_STAT_FName(StatNames.UploadedBytes, Counters.UploadedBytes);
+#endif
+
+#if CSV_PROFILER
+		const FShaderTestPassCsvStatNames& CsvStatNames = GetShaderTestPassCsvStatNames(EShaderTestPass(PassIndex));
+		FCsvProfiler::RecordCustomStat(CsvStatNames.GPU, CSV_CATEGORY_INDEX(ShaderTest), GPUMs, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvStatNames.DrawCalls, CSV_CATEGORY_INDEX(ShaderTest), Counters.DrawCalls, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvStatNames.UploadedBytes, CSV_CATEGORY_INDEX(ShaderTest), float(Counters.UploadedBytes), ECsvCustomStatOp::Set);
+#endif
+
+		FShaderTestPassStats& Stats = GLatestStats[PassIndex];
+		Stats.RenderThreadMs = float(FPlatformTime::ToMilliseconds64(Counters.CPUCycles));
+		Stats.GPUMs = GPUMs;
+		Stats.DrawCalls = Counters.DrawCalls;
+		Stats.UploadedBytes = Counters.UploadedBytes;
+
+		GRenderThreadCounters[PassIndex] = FShaderTestPassCounters();
+	}
+}
+
+
+void FShaderTestPassProfiler::GetStats(TArray<FShaderTestPassStats>& OutStats)
+{
+	check(IsInGameThread());
+
+	FScopeLock Lock(&GLatestStatsLock);
+
+	OutStats.SetNum(int32(EShaderTestPass::Num));
+	for (int32 PassIndex = 0; PassIndex < int32(EShaderTestPass::Num); PassIndex++)
+	{
+		OutStats[PassIndex] = GLatestStats[PassIndex];
+		OutStats[PassIndex].Name = GShaderTestPassNames[PassIndex];
+	}
+}
+
+
+void FShaderTestPassProfiler::Startup()
+{
+	GEndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic([]()
+	{
+		FScopeLock Lock(&GLatestStatsLock);
+
+		for (int32 PassIndex = 0; PassIndex < int32(EShaderTestPass::Num); PassIndex++)
+		{
+			FShaderTestPassStats& Stats = GLatestStats[PassIndex];
+			Stats.GameThreadMs = float(FPlatformTime::ToMilliseconds64(GGameThreadCounters[PassIndex].CPUCycles));
+			Stats.NumCalls = GGameThreadCounters[PassIndex].NumCalls;
+
+			GGameThreadCounters[PassIndex] = FShaderTestPassCounters();
+		}
+	});
+}
+
+
+void FShaderTestPassProfiler::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.Remove(GEndFrameHandle);
+
+	// Drops the queries the GPU never resolved, back to the pool before it is released.
+	ENQUEUE_RENDER_COMMAND(ShaderTestDiscardGPUTimes)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			GPendingGPUTimes.Empty();
+			GTimestampQueryPool.SafeRelease();
+		});
+	FlushRenderingCommands();
+}
+
+
+TArray<FShaderTestPassStats> UShaderTestLibrary::GetShaderTestPassStats()
+{
+	TArray<FShaderTestPassStats> Stats;
+	FShaderTestPassProfiler::GetStats(Stats);
+	return Stats;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphDefinitions.h"
+#include "RHIResources.h"
+#include "Common/ShaderTestStats.h"
+
+class FRHICommandList;
+struct FShaderTestPassStats;
+
+
+/** Plugin entry points with their own stats. */
+enum class EShaderTestPass : uint8
+{
+	FirstShader,
+	TextureShader,
+	ComputeShader,
+	LensDistortion,
+	Readback,
+	Num
+};
+
+/** Thread of a timed CPU scope. */
+enum class EShaderTestPassThread : uint8
+{
+	GameThread,
+	RenderThread
+};
+
+
+/**
+ * Per entry point stats, published at the end of every frame to `stat ShaderTest`, the CSV profiler and
+ * UShaderTestLibrary::GetShaderTestPassStats().
+ *
+ * The GPU time comes from timestamps around the passes of the entry point, read back a few frames later without waiting.
+ * The timestamp queries are allocated from a pool and return to it once read.
+ * The draw calls count the draws, dispatches and copies recorded, the uploaded bytes the shader parameters, uniform buffers
+ * and geometry sent to the GPU.
+ */
+class FShaderTestPassProfiler
+{
+public:
+	/** Times a CPU scope of an entry point, see SHADERTEST_PASS_SCOPE. */
+	class FScopedCPUTime
+	{
+	public:
+		FScopedCPUTime(EShaderTestPass InPass, EShaderTestPassThread InThread);
+		~FScopedCPUTime();
+
+	private:
+		EShaderTestPass Pass;
+		EShaderTestPassThread Thread;
+		uint64 StartCycles;
+	};
+
+	/** Render thread. Adds timestamp passes around the passes added in its scope, see SHADERTEST_RDG_GPU_SCOPE. */
+	class FRDGScopedGPUTime
+	{
+	public:
+		FRDGScopedGPUTime(FRDGBuilder& InGraphBuilder, EShaderTestPass InPass);
+		~FRDGScopedGPUTime();
+
+	private:
+		FRDGBuilder& GraphBuilder;
+		EShaderTestPass Pass;
+		FRHIPooledRenderQuery Begin;
+	};
+
+	/** Render thread. Writes timestamps around the commands recorded in its scope, see SHADERTEST_RHI_GPU_SCOPE. */
+	class FRHIScopedGPUTime
+	{
+	public:
+		FRHIScopedGPUTime(FRHICommandList& InRHICmdList, EShaderTestPass InPass);
+		~FRHIScopedGPUTime();
+
+	private:
+		FRHICommandList& RHICmdList;
+		EShaderTestPass Pass;
+		FRHIPooledRenderQuery Begin;
+	};
+
+	/** Render thread. Draws, dispatches and copies of the entry point. */
+	static void AddDrawCalls(EShaderTestPass Pass, int32 NumDrawCalls);
+
+	/** Render thread. Bytes of shader parameters, uniform buffers and geometry the entry point sends to the GPU. */
+	static void AddUploadedBytes(EShaderTestPass Pass, int64 NumBytes);
+
+	/** Render thread. Publishes the frame's render thread and GPU stats, called at the end of the frame after the frame graph flush. */
+	static void EndFrameRenderThread();
+
+	/** Game thread. Stats of the latest frame of every entry point. */
+	static void GetStats(TArray<FShaderTestPassStats>& OutStats);
+
+	/** Render thread. Timestamp query from the pool of the GPU scopes, returned to it when released. */
+	static FRHIPooledRenderQuery AllocateTimestampQuery();
+
+	/** Hooks the game thread's end of frame, called by the module. */
+	static void Startup();
+	static void Shutdown();
+
+private:
+	static void AddGPUTime(EShaderTestPass Pass, FRHIPooledRenderQuery&& Begin, FRHIPooledRenderQuery&& End);
+};
+
+
+/** Times the enclosing scope of an entry point on the game or render thread, in its cycle stat, the CSV profiler
+ *  (and so Insights) and the stats of FShaderTestPassProfiler.
+ *  @param Pass EShaderTestPass member.
+ *  @param Thread GameThread or RenderThread.
+ */
+#define SHADERTEST_PASS_SCOPE(Pass, Thread) \
+	SCOPE_CYCLE_COUNTER(STAT_ShaderTest_##Pass##_##Thread); \
+	CSV_SCOPED_TIMING_STAT(ShaderTest, Pass##_##Thread); \
+	FShaderTestPassProfiler::FScopedCPUTime PREPROCESSOR_JOIN(ShaderTestPassScope, __LINE__)(EShaderTestPass::Pass, EShaderTestPassThread::Thread)
+
+/** Times the RDG passes added in the enclosing scope, in the entry point's GPU stat and GPU time. */
+#define SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, Pass) \
+	RDG_GPU_STAT_SCOPE(GraphBuilder, ShaderTest_##Pass); \
+	FShaderTestPassProfiler::FRDGScopedGPUTime PREPROCESSOR_JOIN(ShaderTestGPUScope, __LINE__)(GraphBuilder, EShaderTestPass::Pass)
+
+/** Times the RHI commands recorded in the enclosing scope, in the entry point's GPU stat and GPU time. */
+#define SHADERTEST_RHI_GPU_SCOPE(RHICmdList, Pass) \
+	SCOPED_GPU_STAT(RHICmdList, ShaderTest_##Pass); \
+	FShaderTestPassProfiler::FRHIScopedGPUTime PREPROCESSOR_JOIN(ShaderTestGPUScope, __LINE__)(RHICmdList, EShaderTestPass::Pass)
@@ -0,0 +1,254 @@
+#include "Common/ShaderTestReadback.h"
+#include "ShaderTestLibrary.h"
+#include "Common/ShaderTestFrameGraph.h"
+#include "Common/ShaderTestPassProfiler.h"
+
+#include "Async/Async.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "RenderGraphUtils.h"
+#include "RenderingThread.h"
+#include "RHIGPUReadback.h"
+
+
+/** Staging textures kept for the next readbacks. */
+static constexpr int32 kReadbackMaxPooledStagingTextures = 4;
+
+
+bool FShaderTestReadbackResult::ToLinearColors(TArray<FLinearColor>& OutColors) const
+{
+	const int32 NumPixels = Size.X * Size.Y;
+	if (!IsValid() || Data.Num() != NumPixels * GPixelFormats[Format].BlockBytes)
+	{
+		return false;
+	}
+
+	OutColors.SetNumUninitialized(NumPixels);
+	switch (Format)
+	{
+	case PF_B8G8R8A8:
+	{
+		const FColor* Colors = reinterpret_cast<const FColor*>(Data.GetData());
+		for (int32 Index = 0; Index < NumPixels; Index++)
+		{
+			OutColors[Index] = bSRGB ? FLinearColor(Colors[Index]) : Colors[Index].ReinterpretAsLinear();
+		}
+		return true;
+	}
+	case PF_R8G8B8A8:
+	{
+		for (int32 Index = 0; Index < NumPixels; Index++)
+		{
+			const uint8* Color = &Data[Index * 4];
+			const FColor Color8(Color[0], Color[1], Color[2], Color[3]);
+			OutColors[Index] = bSRGB ? FLinearColor(Color8) : Color8.ReinterpretAsLinear();
+		}
+		return true;
+	}
+	case PF_FloatRGBA:
+	{
+		const FFloat16Color* Colors = reinterpret_cast<const FFloat16Color*>(Data.GetData());
+		for (int32 Index = 0; Index < NumPixels; Index++)
+		{
+			OutColors[Index] = FLinearColor(Colors[Index]);
+		}
+		return true;
+	}
+	case PF_A32B32G32R32F:
+	{
+		FMemory::Memcpy(OutColors.GetData(), Data.GetData(), Data.Num());
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+
+/** Render thread state of the readbacks. */
+struct FShaderTestReadbackState
+{
+	using FCallback = FShaderTestReadback::FCallback;
+
+	struct FStagingTexture
+	{
+		TUniquePtr<FRHIGPUTextureReadback> Readback;
+		FIntPoint Size;
+		EPixelFormat Format;
+	};
+
+	struct FPendingReadback
+	{
+		FStagingTexture StagingTexture;
+		bool bSRGB = false;
+		FCallback OnReadback;
+	};
+
+	TArray<FPendingReadback> Pending;
+	TArray<FStagingTexture> Pool;
+
+	FStagingTexture AcquireStagingTexture(FIntPoint Size, EPixelFormat Format)
+	{
+		const int32 Index = Pool.IndexOfByPredicate([Size, Format](const FStagingTexture& StagingTexture)
+		{
+			return StagingTexture.Size == Size && StagingTexture.Format == Format;
+		});
+		if (Index != INDEX_NONE)
+		{
+			FStagingTexture StagingTexture = MoveTemp(Pool[Index]);
+			Pool.RemoveAtSwap(Index);
+			return StagingTexture;
+		}
+
+		FStagingTexture StagingTexture;
+		StagingTexture.Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("ShaderTestReadback"));
+		StagingTexture.Size = Size;
+		StagingTexture.Format = Format;
+		return StagingTexture;
+	}
+
+	void ReleaseStagingTexture(FStagingTexture&& StagingTexture)
+	{
+		if (Pool.Num() >= kReadbackMaxPooledStagingTextures)
+		{
+			Pool.RemoveAt(0);
+		}
+		Pool.Add(MoveTemp(StagingTexture));
+	}
+};
+
+static FShaderTestReadbackState GReadbackState;
+
+
+/** Game thread. Queues the readback of the render target, OnReadbackRenderThread is called on the render thread. */
+static void EnqueueReadback(UTextureRenderTarget2D* RenderTarget, FShaderTestReadback::FCallback&& OnReadbackRenderThread)
+{
+	check(IsInGameThread());
+
+	SHADERTEST_PASS_SCOPE(Readback, GameThread);
+
+	FTextureRenderTargetResource* RenderTargetResource = RenderTarget ? RenderTarget->GameThread_GetRenderTargetResource() : nullptr;
+
+	ENQUEUE_RENDER_COMMAND(ShaderTestReadback)(
+		[RenderTargetResource, OnReadbackRenderThread = MoveTemp(OnReadbackRenderThread)](FRHICommandListImmediate& RHICmdList) mutable
+		{
+			SHADERTEST_PASS_SCOPE(Readback, RenderThread);
+
+			FTexture2DRHIRef Texture = RenderTargetResource ? RenderTargetResource->GetRenderTargetTexture() : nullptr;
+			if (!Texture)
+			{
+				OnReadbackRenderThread(FShaderTestReadbackResult());
+				return;
+			}
+
+			FShaderTestReadbackState::FPendingReadback& PendingReadback = GReadbackState.Pending.AddDefaulted_GetRef();
+			PendingReadback.StagingTexture = GReadbackState.AcquireStagingTexture(Texture->GetSizeXY(), Texture->GetFormat());
+			PendingReadback.bSRGB = EnumHasAnyFlags(Texture->GetFlags(), TexCreate_SRGB);
+			PendingReadback.OnReadback = MoveTemp(OnReadbackRenderThread);
+
+			// Queued after the passes already in the frame graph, the staging texture outlives the graph.
+			FRHIGPUTextureReadback* Readback = PendingReadback.StagingTexture.Readback.Get();
+			FShaderTestFrameGraph::AddPasses(RHICmdList, [Texture, Readback](FRDGBuilder& GraphBuilder)
+			{
+				SHADERTEST_PASS_SCOPE(Readback, RenderThread);
+				SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, Readback);
+
+				FRDGTextureRef SourceTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(Texture, TEXT("ShaderTestReadbackSource")));
+				AddEnqueueCopyPass(GraphBuilder, Readback, SourceTexture);
+				GraphBuilder.SetTextureAccessFinal(SourceTexture, ERHIAccess::SRVMask);
+
+				FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::Readback, 1);
+			});
+		});
+}
+
+
+void FShaderTestReadback::ReadbackRenderTarget(UTextureRenderTarget2D* RenderTarget, FCallback&& OnReadback)
+{
+	// Hops back to the game thread with the result.
+	EnqueueReadback(RenderTarget, [OnReadback = MoveTemp(OnReadback)](FShaderTestReadbackResult&& Result) mutable
+	{
+		AsyncTask(ENamedThreads::GameThread, [OnReadback = MoveTemp(OnReadback), Result = MoveTemp(Result)]() mutable
+		{
+			OnReadback(MoveTemp(Result));
+		});
+	});
+}
+
+
+TFuture<FShaderTestReadbackResult> FShaderTestReadback::ReadbackRenderTarget(UTextureRenderTarget2D* RenderTarget)
+{
+	TSharedRef<TPromise<FShaderTestReadbackResult>> Promise = MakeShared<TPromise<FShaderTestReadbackResult>>();
+	TFuture<FShaderTestReadbackResult> Future = Promise->GetFuture();
+
+	EnqueueReadback(RenderTarget, [Promise](FShaderTestReadbackResult&& Result)
+	{
+		Promise->SetValue(MoveTemp(Result));
+	});
+
+	return Future;
+}
+
+
+void FShaderTestReadback::Poll(FRHICommandListImmediate& RHICmdList)
+{
+	check(IsInRenderingThread());
+
+	// Delivered in the order they were queued.
+	while (GReadbackState.Pending.Num() > 0 && GReadbackState.Pending[0].StagingTexture.Readback->IsReady())
+	{
+		FShaderTestReadbackState::FPendingReadback PendingReadback = MoveTemp(GReadbackState.Pending[0]);
+		GReadbackState.Pending.RemoveAt(0);
+
+		const FIntPoint Size = PendingReadback.StagingTexture.Size;
+		const EPixelFormat Format = PendingReadback.StagingTexture.Format;
+		const int32 BytesPerPixel = GPixelFormats[Format].BlockBytes;
+
+		FShaderTestReadbackResult Result;
+		Result.Size = Size;
+		Result.Format = Format;
+		Result.bSRGB = PendingReadback.bSRGB;
+
+		void* Source = nullptr;
+		int32 RowPitchInPixels = 0;
+		PendingReadback.StagingTexture.Readback->LockTexture(RHICmdList, Source, RowPitchInPixels);
+		if (Source)
+		{
+			Result.Data.SetNumUninitialized(Size.X * Size.Y * BytesPerPixel);
+			for (int32 Y = 0; Y < Size.Y; Y++)
+			{
+				FMemory::Memcpy(&Result.Data[Y * Size.X * BytesPerPixel], static_cast<const uint8*>(Source) + Y * RowPitchInPixels * BytesPerPixel, Size.X * BytesPerPixel);
+			}
+		}
+		PendingReadback.StagingTexture.Readback->Unlock();
+
+		GReadbackState.ReleaseStagingTexture(MoveTemp(PendingReadback.StagingTexture));
+		PendingReadback.OnReadback(MoveTemp(Result));
+	}
+}
+
+
+void FShaderTestReadback::Shutdown()
+{
+	ENQUEUE_RENDER_COMMAND(ShaderTestDiscardReadbacks)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			for (FShaderTestReadbackState::FPendingReadback& PendingReadback : GReadbackState.Pending)
+			{
+				PendingReadback.OnReadback(FShaderTestReadbackResult());
+			}
+			GReadbackState.Pending.Empty();
+			GReadbackState.Pool.Empty();
+		});
+	FlushRenderingCommands();
+}
+
+
+void UShaderTestLibrary::ReadbackRenderTargetAsync(UTextureRenderTarget2D* RenderTarget, FShaderTestReadbackDelegate OnReadback)
+{
+	FShaderTestReadback::ReadbackRenderTarget(RenderTarget, [OnReadback](FShaderTestReadbackResult&& Result)
+	{
+		TArray<FLinearColor> Pixels;
+		const bool bSuccess = Result.ToLinearColors(Pixels);
+		OnReadback.ExecuteIfBound(bSuccess, Pixels, Result.Size);
+	});
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "Async/Future.h"
+
+class FRHICommandListImmediate;
+class UTextureRenderTarget2D;
+
+
+/** Pixels read back from a render target. */
+struct FShaderTestReadbackResult
+{
+	FIntPoint Size = FIntPoint::ZeroValue;
+	EPixelFormat Format = PF_Unknown;
+	/** The render target was sampled as sRGB, its 8 bit values are gamma encoded. */
+	bool bSRGB = false;
+
+	/** Tightly packed rows of Format, empty when the readback failed. */
+	TArray<uint8> Data;
+
+	bool IsValid() const
+	{
+		return Data.Num() > 0;
+	}
+
+	/** Decodes the 8 bit RGBA/BGRA and the 16/32 bit float RGBA formats, returns false for the others.
+	 *  The 8 bit values are converted from sRGB only when bSRGB is set.
+	 */
+	bool ToLinearColors(TArray<FLinearColor>& OutColors) const;
+};
+
+
+/**
+ * Non-blocking readback of the plugin render targets.
+ *
+ * The copy is queued in the frame graph after the passes drawing the render target, and the staging texture is
+ * polled at the end of every frame. The result is delivered once the GPU is done, the staging textures are pooled.
+ */
+class FShaderTestReadback
+{
+public:
+	using FCallback = TUniqueFunction<void(FShaderTestReadbackResult&& Result)>;
+
+	/** Game thread. Calls OnReadback on the game thread with the content of the render target after the draws enqueued so far. */
+	static void ReadbackRenderTarget(UTextureRenderTarget2D* RenderTarget, FCallback&& OnReadback);
+
+	/** Game thread. Same as above, the future is fulfilled from the render thread. */
+	static TFuture<FShaderTestReadbackResult> ReadbackRenderTarget(UTextureRenderTarget2D* RenderTarget);
+
+	/** Render thread. Delivers the readbacks the GPU is done with, called at the end of the frame after the frame graph flush. */
+	static void Poll(FRHICommandListImmediate& RHICmdList);
+
+	/** Drops the pending readbacks and the pooled staging textures, called by the module. */
+	static void Shutdown();
+};
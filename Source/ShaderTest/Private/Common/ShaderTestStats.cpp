@@ -0,0 +1,19 @@
+#include "Common/ShaderTestStats.h"
+
+DEFINE_STAT(STAT_ShaderTest_FullScreenDraws);
+DEFINE_STAT(STAT_ShaderTest_DisplacementCacheHits);
+DEFINE_STAT(STAT_ShaderTest_DisplacementCacheMisses);
+DEFINE_STAT(STAT_ShaderTest_AnimatedDisplacementUpdates);
+DEFINE_STAT(STAT_ShaderTest_AnimatedDisplacementSkips);
+DEFINE_STAT(STAT_ShaderTest_TextureArraySliceUploads);
+DEFINE_STAT(STAT_ShaderTest_DisplacementCacheMemory);
+DEFINE_STAT(STAT_ShaderTest_AnimatedDisplacementMemory);
+DEFINE_STAT(STAT_ShaderTest_TextureArrayMemory);
+
+DEFINE_SHADERTEST_PASS_STATS(FirstShader);
+DEFINE_SHADERTEST_PASS_STATS(TextureShader);
+DEFINE_SHADERTEST_PASS_STATS(ComputeShader);
+DEFINE_SHADERTEST_PASS_STATS(LensDistortion);
+DEFINE_SHADERTEST_PASS_STATS(Readback);
+
+CSV_DEFINE_CATEGORY(ShaderTest, true);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/RealtimeGPUProfiler.h"
+
+DECLARE_STATS_GROUP(TEXT("ShaderTest"), STATGROUP_ShaderTest, STATCAT_Advanced);
+
+/** Full screen triangles drawn by the plugin this frame. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Full Screen Draws"), STAT_ShaderTest_FullScreenDraws, STATGROUP_ShaderTest, );
+
+/** Lens distortion displacement maps served by the cache this frame, without drawing the grid pass. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Displacement Cache Hits"), STAT_ShaderTest_DisplacementCacheHits, STATGROUP_ShaderTest, );
+
+/** Lens distortion displacement maps drawn by the cache this frame. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Displacement Cache Misses"), STAT_ShaderTest_DisplacementCacheMisses, STATGROUP_ShaderTest, );
+
+/** Animated lens distortion displacement maps generated this frame, on async compute. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Animated Displacement Updates"), STAT_ShaderTest_AnimatedDisplacementUpdates, STATGROUP_ShaderTest, );
+
+/** Animated lens distortion displacement maps skipped this frame, the camera model moved less than the epsilon. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Animated Displacement Skips"), STAT_ShaderTest_AnimatedDisplacementSkips, STATGROUP_ShaderTest, );
+
+/** Texture array slices copied from their source texture this frame, the slices already holding their source are not copied. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Texture Array Slice Uploads"), STAT_ShaderTest_TextureArraySliceUploads, STATGROUP_ShaderTest, );
+
+/** GPU memory of the cached lens distortion displacement maps. */
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Displacement Cache Memory"), STAT_ShaderTest_DisplacementCacheMemory, STATGROUP_ShaderTest, );
+
+/** GPU memory of the double buffered displacement maps of the animated lenses. */
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Animated Displacement Memory"), STAT_ShaderTest_AnimatedDisplacementMemory, STATGROUP_ShaderTest, );
+
+/** GPU memory of the texture arrays packing the sources of the texture shader sprites. */
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Texture Array Memory"), STAT_ShaderTest_TextureArrayMemory, STATGROUP_ShaderTest, );
+
+/** Stats of a plugin entry point, see FShaderTestPassProfiler:
+ *  game thread enqueue and render thread record cycles, GPU time from its timestamps, draw calls and uploaded bytes of the frame,
+ *  and its GPU stat in `stat GPU`, ProfileGPU and the CSV profiler.
+ */
+#define DECLARE_SHADERTEST_PASS_STATS_EXTERN(Pass) \
+	DECLARE_CYCLE_STAT_EXTERN(TEXT(#Pass " Enqueue (Game Thread)"), STAT_ShaderTest_##Pass##_GameThread, STATGROUP_ShaderTest, ); \
+	DECLARE_CYCLE_STAT_EXTERN(TEXT(#Pass " Record (Render Thread)"), STAT_ShaderTest_##Pass##_RenderThread, STATGROUP_ShaderTest, ); \
+	DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT(#Pass " GPU ms"), STAT_ShaderTest_##Pass##_GPU, STATGROUP_ShaderTest, ); \
+	DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT(#Pass " Draw Calls"), STAT_ShaderTest_##Pass##_DrawCalls, STATGROUP_ShaderTest, ); \
+	DECLARE_MEMORY_STAT_EXTERN(TEXT(#Pass " Uploaded Bytes"), STAT_ShaderTest_##Pass##_UploadedBytes, STATGROUP_ShaderTest, ); \
+	DECLARE_GPU_STAT_NAMED_EXTERN(ShaderTest_##Pass, TEXT("ShaderTest " #Pass))
+
+#define DEFINE_SHADERTEST_PASS_STATS(Pass) \
+	DEFINE_STAT(STAT_ShaderTest_##Pass##_GameThread); \
+	DEFINE_STAT(STAT_ShaderTest_##Pass##_RenderThread); \
+	DEFINE_STAT(STAT_ShaderTest_##Pass##_GPU); \
+	DEFINE_STAT(STAT_ShaderTest_##Pass##_DrawCalls); \
+	DEFINE_STAT(STAT_ShaderTest_##Pass##_UploadedBytes); \
+	DEFINE_GPU_STAT(ShaderTest_##Pass)
+
+DECLARE_SHADERTEST_PASS_STATS_EXTERN(FirstShader);
+DECLARE_SHADERTEST_PASS_STATS_EXTERN(TextureShader);
+DECLARE_SHADERTEST_PASS_STATS_EXTERN(ComputeShader);
+DECLARE_SHADERTEST_PASS_STATS_EXTERN(LensDistortion);
+DECLARE_SHADERTEST_PASS_STATS_EXTERN(Readback);
+
+CSV_DECLARE_CATEGORY_EXTERN(ShaderTest);
@@ -1,51 +1,18 @@
 #include "Common/TestShaderUtils.h"
+#include "Common/ShaderTestStats.h"
+#include "CommonRenderResources.h"
 
 
-FBufferRHIRef UTestShaderUtils::CreateVertexBuffer(const TArray<FVector4>& VertexList)
+void UTestShaderUtils::SetupFullScreenTriangle(FGraphicsPipelineStateInitializer& GraphicsPSOInit)
 {
-	FRHIResourceCreateInfo CreateInfo(TEXT(""));
-	FBufferRHIRef VertexBufferRHI = RHICreateVertexBuffer(sizeof(FVector4) * VertexList.Num(), BUF_Volatile, CreateInfo);
-	void* VoidPtr = RHILockBuffer(VertexBufferRHI, 0, sizeof(FVector4) * VertexList.Num(), RLM_WriteOnly);
-
-	FVector4* Vertices = (FVector4*)VoidPtr;
-
-	for (int i = 0; i < VertexList.Num(); i++)
-	{
-		Vertices[i] = VertexList[i];
-	}
-
-	RHIUnlockBuffer(VertexBufferRHI);
-	return VertexBufferRHI;
-}
-
-FBufferRHIRef UTestShaderUtils::CreateVertexBuffer(const TArray<FMyTextureVertex>& VertexList)
-{
-	TResourceArray<FMyTextureVertex, VERTEXBUFFER_ALIGNMENT> Vertices;
-	Vertices.SetNumUninitialized(VertexList.Num());
-
-	for (int i = 0; i < VertexList.Num(); i++)
-	{
-		Vertices[i] = VertexList[i];
-	}
-
-	// Create vertex buffer. Fill buffer with initial data upon creation
-	FRHIResourceCreateInfo CreateInfo(TEXT(""), &Vertices);
-	FBufferRHIRef VertexBufferRHI = RHICreateVertexBuffer(Vertices.GetResourceDataSize(), BUF_Static, CreateInfo);
-
-	return VertexBufferRHI;
+	GraphicsPSOInit.PrimitiveType = PT_TriangleList;
+	GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GEmptyVertexDeclaration.VertexDeclarationRHI;
 }
 
-
-FBufferRHIRef UTestShaderUtils::CreateIndexBuffer(const uint16* Indices, uint16 NumIndices)
+void UTestShaderUtils::DrawFullScreenTriangle(FRHICommandList& RHICmdList, uint32 NumInstances)
 {
-	TResourceArray<uint16, INDEXBUFFER_ALIGNMENT> IndexBuffer;
-
-	IndexBuffer.AddUninitialized(NumIndices);
-	FMemory::Memcpy(IndexBuffer.GetData(), Indices, NumIndices * sizeof(uint16));
-
-	// Create index buffer. Fill buffer with initial data upon creation
-	FRHIResourceCreateInfo CreateInfo(TEXT(""), &IndexBuffer);
-	FBufferRHIRef IndexBufferRHI = RHICreateIndexBuffer(sizeof(uint16), IndexBuffer.GetResourceDataSize(), BUF_Static, CreateInfo);
+	INC_DWORD_STAT(STAT_ShaderTest_FullScreenDraws);
 
-	return IndexBufferRHI;
+	// The 3 vertices are generated from SV_VertexID in FullScreenTriangleVS.
+	RHICmdList.DrawPrimitive(0, 1, NumInstances);
 }
\ No newline at end of file
@@ -2,18 +2,8 @@
 
 #include "TestShaderUtils.generated.h"
 
-
-struct FMyTextureVertex
-{
-	FVector4 Position;
-	FVector2D UV;
-
-	FMyTextureVertex(FVector4 ParamPos, FVector2D ParamUV)
-	{
-		Position = ParamPos;
-		UV = ParamUV;
-	}
-};
+class FRHICommandList;
+class FGraphicsPipelineStateInitializer;
 
 
 UCLASS()
@@ -23,9 +13,9 @@ class UTestShaderUtils : public UObject
 
 public:
 
-	static FBufferRHIRef CreateVertexBuffer(const TArray<FVector4>& VertexList);
-
-	static FBufferRHIRef CreateVertexBuffer(const TArray<FMyTextureVertex>& VertexList);
+	/** Sets up the pipeline state to draw a full screen triangle generated from SV_VertexID (see MyFullScreenTriangle.ush). */
+	static void SetupFullScreenTriangle(FGraphicsPipelineStateInitializer& GraphicsPSOInit);
 
-	static FBufferRHIRef CreateIndexBuffer(const uint16* Indices, uint16 NumIndices);
+	/** Draws the full screen triangle, no vertex or index buffer is created or bound. */
+	static void DrawFullScreenTriangle(FRHICommandList& RHICmdList, uint32 NumInstances = 1);
 };
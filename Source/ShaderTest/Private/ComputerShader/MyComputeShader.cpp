@@ -1,3 +1,3 @@
-// #include "ComputerShader/MyComputeShader.h"
-// 
-// IMPLEMENT_SHADER_TYPE(, FMyComputeShader, TEXT("/Plugin/ShaderTest/Private/TestComputeShader.usf"), TEXT("MainCS"), SF_Compute);
\ No newline at end of file
+#include "ComputerShader/MyComputeShader.h"
+
+IMPLEMENT_GLOBAL_SHADER(FMyComputeShader, "/Plugin/ShaderTest/Private/TestComputeShader.usf", "MainCS", SF_Compute);
@@ -0,0 +1,415 @@
+#include "ComputerShader/MyComputeShaderCPU.h"
+
+#include "ImageCore.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Math/Float16Color.h"
+#include "Math/VectorRegister.h"
+
+
+/** Vector registers of 4 pixels evaluated together, interleaved to hide the latency of the divides. */
+static constexpr int32 kMyComputeShaderRegistersPerGroup = 2;
+
+/** Pixels of a row evaluated together. */
+static constexpr int32 kMyComputeShaderPixelsPerGroup = 4 * kMyComputeShaderRegistersPerGroup;
+
+/** Size of the tiles handed to the cores, a multiple of the pixel groups. */
+static constexpr int32 kMyComputeShaderTileSize = 32;
+
+
+/** Per image terms of MainCS. */
+struct FMyComputeShaderCPUConstants
+{
+	FVector2f OutputSize;
+	int32 NumSteps;
+	float StepSize;
+
+	/** t = TimeOffset + (TimeNumerator / (length(uv) + 0.07)) * 2.2 */
+	float TimeOffset;
+	float TimeNumerator;
+
+	/** Phases of the sin() of v1 and v2. */
+	float Phase1;
+	float Phase2;
+
+	/** Depth offset of the marched position. */
+	float OffsetZ;
+
+	/** Scale of the red channel. */
+	float ColorScaleR;
+
+	FMyComputeShaderCPUConstants(FIntPoint InOutputSize, float GlobalTime, int32 InNumSteps)
+		: OutputSize(float(InOutputSize.X), float(InOutputSize.Y))
+		, NumSteps(InNumSteps)
+		, StepSize(0.035f * 90.f / float(InNumSteps))
+		, TimeOffset(GlobalTime * 0.1f)
+		, TimeNumerator(0.25f + 0.05f * FMath::Sin(GlobalTime * 0.1f))
+		, Phase1(0.5f - GlobalTime * 0.2f)
+		, Phase2(1.2f - GlobalTime * 0.3f)
+		, OffsetZ(1.5f + FMath::Sin(GlobalTime * 0.13f) * 0.1f)
+		, ColorScaleR(1.5f + FMath::Sin(GlobalTime * 0.2f) * 0.4f)
+	{ }
+};
+
+
+/** Colors of 4 consecutive pixels, a register per channel, alpha is 1. */
+struct FMyComputeShaderPixels4
+{
+	VectorRegister4Float R;
+	VectorRegister4Float G;
+	VectorRegister4Float B;
+};
+
+
+/** Evaluates MainCS on the pixels [X, X + kMyComputeShaderPixelsPerGroup[ of the row Y. */
+static void EvaluateMyComputeShaderGroup(const FMyComputeShaderCPUConstants& Constants, int32 X, int32 Y, FMyComputeShaderPixels4 (&OutPixels)[kMyComputeShaderRegistersPerGroup])
+{
+	constexpr int32 NumRegisters = kMyComputeShaderRegistersPerGroup;
+
+	const VectorRegister4Float One = GlobalVectorConstants::FloatOne;
+	const VectorRegister4Float LaneOffsets = MakeVectorRegisterFloat(0.f, 1.f, 2.f, 3.f);
+	const VectorRegister4Float FractalOffset = VectorSetFloat1(-0.659f);
+
+	// uv.y is shared by the whole row.
+	const float UVY = float(Y) / Constants.OutputSize.Y - 0.5f;
+
+	VectorRegister4Float UVX[NumRegisters];
+	VectorRegister4Float Len[NumRegisters];
+	VectorRegister4Float Sin[NumRegisters];
+	VectorRegister4Float Cos[NumRegisters];
+	VectorRegister4Float Amplitude1[NumRegisters];
+	VectorRegister4Float Amplitude2[NumRegisters];
+
+	for (int32 Register = 0; Register < NumRegisters; Register++)
+	{
+		const VectorRegister4Float PixelX = VectorAdd(VectorSetFloat1(float(X + 4 * Register)), LaneOffsets);
+		UVX[Register] = VectorSubtract(VectorDivide(PixelX, VectorSetFloat1(Constants.OutputSize.X)), GlobalVectorConstants::FloatOneHalf);
+		Len[Register] = VectorSqrt(VectorMultiplyAdd(UVX[Register], UVX[Register], VectorSetFloat1(UVY * UVY)));
+
+		const VectorRegister4Float T = VectorMultiplyAdd(
+			VectorDivide(VectorSetFloat1(Constants.TimeNumerator), VectorAdd(Len[Register], VectorSetFloat1(0.07f))),
+			VectorSetFloat1(2.2f),
+			VectorSetFloat1(Constants.TimeOffset));
+		VectorSinCos(&Sin[Register], &Cos[Register], &T);
+
+		// length(uv.xy * 13.0) == 13.0 * length(uv), the 0.0015 and 0.0013 factors of the dot products are folded in.
+		Amplitude1[Register] = VectorMultiply(VectorSetFloat1(0.0015f),
+			VectorAdd(VectorSetFloat1(1.8f), VectorSin(VectorMultiplyAdd(Len[Register], VectorSetFloat1(13.f), VectorSetFloat1(Constants.Phase1)))));
+		Amplitude2[Register] = VectorMultiply(VectorSetFloat1(0.0013f),
+			VectorAdd(VectorSetFloat1(1.5f), VectorSin(VectorMultiplyAdd(Len[Register], VectorSetFloat1(14.5f), VectorSetFloat1(Constants.Phase2)))));
+	}
+
+	VectorRegister4Float V1[NumRegisters];
+	VectorRegister4Float V2[NumRegisters];
+	VectorRegister4Float V3[NumRegisters];
+	for (int32 Register = 0; Register < NumRegisters; Register++)
+	{
+		V1[Register] = V2[Register] = V3[Register] = GlobalVectorConstants::FloatZero;
+	}
+
+	float S = 0.f;
+	for (int32 Step = 0; Step < Constants.NumSteps; Step++)
+	{
+		const VectorRegister4Float SX = VectorSetFloat1(S);
+		const VectorRegister4Float SY = VectorSetFloat1(S * UVY);
+
+		VectorRegister4Float PX[NumRegisters];
+		VectorRegister4Float PY[NumRegisters];
+		VectorRegister4Float PZ[NumRegisters];
+
+		// p.xy = mul(s * uv, ma) + (0.22, 0.3), p.z is the same for all the pixels.
+		for (int32 Register = 0; Register < NumRegisters; Register++)
+		{
+			const VectorRegister4Float X0 = VectorMultiply(SX, UVX[Register]);
+			PX[Register] = VectorAdd(VectorSubtract(VectorMultiply(X0, Cos[Register]), VectorMultiply(SY, Sin[Register])), VectorSetFloat1(0.22f));
+			PY[Register] = VectorAdd(VectorMultiplyAdd(X0, Sin[Register], VectorMultiply(SY, Cos[Register])), VectorSetFloat1(0.3f));
+			PZ[Register] = VectorSetFloat1(S - Constants.OffsetZ);
+		}
+
+		for (int32 Iteration = 0; Iteration < 8; Iteration++)
+		{
+			for (int32 Register = 0; Register < NumRegisters; Register++)
+			{
+				const VectorRegister4Float LengthSquared = VectorMultiplyAdd(PX[Register], PX[Register],
+					VectorMultiplyAdd(PY[Register], PY[Register], VectorMultiply(PZ[Register], PZ[Register])));
+				const VectorRegister4Float InvLengthSquared = VectorDivide(One, LengthSquared);
+
+				PX[Register] = VectorMultiplyAdd(VectorAbs(PX[Register]), InvLengthSquared, FractalOffset);
+				PY[Register] = VectorMultiplyAdd(VectorAbs(PY[Register]), InvLengthSquared, FractalOffset);
+				PZ[Register] = VectorMultiplyAdd(VectorAbs(PZ[Register]), InvLengthSquared, FractalOffset);
+			}
+		}
+
+		for (int32 Register = 0; Register < NumRegisters; Register++)
+		{
+			const VectorRegister4Float LengthXYSquared = VectorMultiplyAdd(PX[Register], PX[Register], VectorMultiply(PY[Register], PY[Register]));
+			const VectorRegister4Float LengthSquared = VectorMultiplyAdd(PZ[Register], PZ[Register], LengthXYSquared);
+
+			V1[Register] = VectorMultiplyAdd(LengthSquared, Amplitude1[Register], V1[Register]);
+			V2[Register] = VectorMultiplyAdd(LengthSquared, Amplitude2[Register], V2[Register]);
+
+			// length(p.xy * 10.0) * 0.0003
+			V3[Register] = VectorMultiplyAdd(VectorSqrt(LengthXYSquared), VectorSetFloat1(0.003f), V3[Register]);
+		}
+
+		S += Constants.StepSize;
+	}
+
+	const VectorRegister4Float Exponent = VectorSetFloat1(1.2f);
+
+	for (int32 Register = 0; Register < NumRegisters; Register++)
+	{
+		// lerp(A, 0.0, len) == A * (1.0 - len)
+		const VectorRegister4Float OneMinusLen = VectorSubtract(One, Len[Register]);
+		const VectorRegister4Float FinalV1 = VectorMultiply(V1[Register], VectorMultiply(OneMinusLen, VectorSetFloat1(0.7f)));
+		const VectorRegister4Float FinalV2 = VectorMultiply(V2[Register], VectorMultiply(OneMinusLen, VectorSetFloat1(0.5f)));
+		const VectorRegister4Float FinalV3 = VectorMultiply(V3[Register], VectorMultiply(OneMinusLen, VectorSetFloat1(0.9f)));
+
+		// lerp(0.2, 0.0, len) * 0.85 + lerp(0.0, 0.6, v3) * 0.3
+		const VectorRegister4Float Add = VectorMultiplyAdd(OneMinusLen, VectorSetFloat1(0.17f), VectorMultiply(FinalV3, VectorSetFloat1(0.18f)));
+
+		const VectorRegister4Float Channels[3] =
+		{
+			VectorMultiplyAdd(FinalV3, VectorSetFloat1(Constants.ColorScaleR), Add),
+			VectorMultiplyAdd(VectorAdd(FinalV1, FinalV3), VectorSetFloat1(0.3f), Add),
+			VectorAdd(FinalV2, Add),
+		};
+
+		OutPixels[Register].R = VectorMin(VectorPow(VectorAbs(Channels[0]), Exponent), One);
+		OutPixels[Register].G = VectorMin(VectorPow(VectorAbs(Channels[1]), Exponent), One);
+		OutPixels[Register].B = VectorMin(VectorPow(VectorAbs(Channels[2]), Exponent), One);
+	}
+}
+
+
+/** Transposes 4 channel registers into a register per pixel, holding its channels in the order of the arguments. */
+static FORCEINLINE void TransposeMyComputeShaderPixels(
+	const VectorRegister4Float& C0,
+	const VectorRegister4Float& C1,
+	const VectorRegister4Float& C2,
+	const VectorRegister4Float& C3,
+	VectorRegister4Float (&OutPixels)[4])
+{
+	const VectorRegister4Float C01Low = VectorShuffle(C0, C1, 0, 1, 0, 1);
+	const VectorRegister4Float C23Low = VectorShuffle(C2, C3, 0, 1, 0, 1);
+	const VectorRegister4Float C01High = VectorShuffle(C0, C1, 2, 3, 2, 3);
+	const VectorRegister4Float C23High = VectorShuffle(C2, C3, 2, 3, 2, 3);
+
+	OutPixels[0] = VectorShuffle(C01Low, C23Low, 0, 2, 0, 2);
+	OutPixels[1] = VectorShuffle(C01Low, C23Low, 1, 3, 1, 3);
+	OutPixels[2] = VectorShuffle(C01High, C23High, 0, 2, 0, 2);
+	OutPixels[3] = VectorShuffle(C01High, C23High, 1, 3, 1, 3);
+}
+
+
+/** sRGB transfer function of the [0, 1] channels, as FLinearColor::ToFColor(true). */
+static FORCEINLINE VectorRegister4Float MyComputeShaderLinearToSRGB(const VectorRegister4Float& Linear)
+{
+	const VectorRegister4Float Low = VectorMultiply(Linear, VectorSetFloat1(12.92f));
+	const VectorRegister4Float High = VectorMultiplyAdd(VectorPow(Linear, VectorSetFloat1(1.f / 2.4f)), VectorSetFloat1(1.055f), VectorSetFloat1(-0.055f));
+	return VectorSelect(VectorCompareLE(Linear, VectorSetFloat1(0.0031308f)), Low, High);
+}
+
+
+/** Writes the 4 pixels at Offset of the image in its format, straight from the registers. */
+static void StoreMyComputeShaderPixels(FImage& Image, int64 Offset, const FMyComputeShaderPixels4& Pixels)
+{
+	VectorRegister4Float Transposed[4];
+
+	switch (Image.Format)
+	{
+	case ERawImageFormat::RGBA32F:
+	{
+		TransposeMyComputeShaderPixels(Pixels.R, Pixels.G, Pixels.B, GlobalVectorConstants::FloatOne, Transposed);
+
+		float* Dst = &Image.AsRGBA32F().GetData()[Offset].R;
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			VectorStore(Transposed[Lane], Dst + 4 * Lane);
+		}
+		break;
+	}
+
+	case ERawImageFormat::RGBA16F:
+	{
+		TransposeMyComputeShaderPixels(Pixels.R, Pixels.G, Pixels.B, GlobalVectorConstants::FloatOne, Transposed);
+
+		// The half conversion has no vector store in this engine version, it goes through the pixel's register.
+		FFloat16Color* Dst = Image.AsRGBA16F().GetData() + Offset;
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			FLinearColor Color;
+			VectorStore(Transposed[Lane], &Color.R);
+			Dst[Lane] = FFloat16Color(Color);
+		}
+		break;
+	}
+
+	case ERawImageFormat::BGRA8:
+	{
+		// Same quantization as a UNorm render target, unless the image is gamma encoded: rounded, the channels are in [0, 1].
+		const bool bSRGB = Image.GammaSpace != EGammaSpace::Linear;
+		const VectorRegister4Float Scale = VectorSetFloat1(255.f);
+		const VectorRegister4Float Half = GlobalVectorConstants::FloatOneHalf;
+		const VectorRegister4Float R = VectorMultiplyAdd(bSRGB ? MyComputeShaderLinearToSRGB(Pixels.R) : Pixels.R, Scale, Half);
+		const VectorRegister4Float G = VectorMultiplyAdd(bSRGB ? MyComputeShaderLinearToSRGB(Pixels.G) : Pixels.G, Scale, Half);
+		const VectorRegister4Float B = VectorMultiplyAdd(bSRGB ? MyComputeShaderLinearToSRGB(Pixels.B) : Pixels.B, Scale, Half);
+
+		// FColor is stored B, G, R, A.
+		TransposeMyComputeShaderPixels(B, G, R, Scale, Transposed);
+
+		FColor* Dst = Image.AsBGRA8().GetData() + Offset;
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			VectorStoreByte4(Transposed[Lane], Dst + Lane);
+		}
+		break;
+	}
+
+	default:
+		checkNoEntry();
+	}
+}
+
+
+/** Scalar StoreMyComputeShaderPixels() of the first NumLanes pixels, for the group crossing the image's right edge. */
+static void StoreMyComputeShaderPixelsTail(FImage& Image, int64 Offset, const FMyComputeShaderPixels4& Pixels, int32 NumLanes)
+{
+	MS_ALIGN(16) float Stored[3][4] GCC_ALIGN(16);
+	VectorStoreAligned(Pixels.R, Stored[0]);
+	VectorStoreAligned(Pixels.G, Stored[1]);
+	VectorStoreAligned(Pixels.B, Stored[2]);
+
+	const bool bSRGB = Image.GammaSpace != EGammaSpace::Linear;
+
+	for (int32 Lane = 0; Lane < NumLanes; Lane++)
+	{
+		const FLinearColor Color(Stored[0][Lane], Stored[1][Lane], Stored[2][Lane], 1.f);
+
+		switch (Image.Format)
+		{
+		case ERawImageFormat::RGBA32F:
+			Image.AsRGBA32F().GetData()[Offset + Lane] = Color;
+			break;
+
+		case ERawImageFormat::RGBA16F:
+			Image.AsRGBA16F().GetData()[Offset + Lane] = FFloat16Color(Color);
+			break;
+
+		case ERawImageFormat::BGRA8:
+			Image.AsBGRA8().GetData()[Offset + Lane] = Color.ToFColor(bSRGB);
+			break;
+
+		default:
+			checkNoEntry();
+		}
+	}
+}
+
+
+bool DrawMyComputeShaderToImage_CPU(FImage& Image, float GlobalTime, int32 NumSteps, int32 NumWorkers)
+{
+	if (Image.Format != ERawImageFormat::RGBA32F && Image.Format != ERawImageFormat::RGBA16F && Image.Format != ERawImageFormat::BGRA8)
+	{
+		UE_LOG(LogTemp, Error, TEXT("DrawMyComputeShaderToImage_CPU, unsupported image format %d"), int32(Image.Format));
+		return false;
+	}
+
+	check(Image.SizeX > 0 && Image.SizeY > 0);
+	check(Image.RawData.Num() >= int64(Image.SizeX) * Image.SizeY * Image.GetBytesPerPixel());
+
+	const FMyComputeShaderCPUConstants Constants(FIntPoint(Image.SizeX, Image.SizeY), GlobalTime, FMath::Max(NumSteps, 1));
+
+	const FIntPoint NumTilesXY(
+		FMath::DivideAndRoundUp(Image.SizeX, kMyComputeShaderTileSize),
+		FMath::DivideAndRoundUp(Image.SizeY, kMyComputeShaderTileSize));
+	const int32 NumTiles = NumTilesXY.X * NumTilesXY.Y;
+
+	if (NumWorkers <= 0)
+	{
+		NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	}
+	NumWorkers = FMath::Min(NumWorkers, NumTiles);
+
+	// Each worker pulls the next tile, so NumWorkers bounds the cores in use whatever the tile costs.
+	FThreadSafeCounter NextTile;
+
+	ParallelFor(NumWorkers, [&](int32 WorkerIndex)
+	{
+		for (int32 Tile = NextTile.Increment() - 1; Tile < NumTiles; Tile = NextTile.Increment() - 1)
+		{
+			const int32 MinX = Tile % NumTilesXY.X * kMyComputeShaderTileSize;
+			const int32 MinY = Tile / NumTilesXY.X * kMyComputeShaderTileSize;
+			const int32 MaxX = FMath::Min(MinX + kMyComputeShaderTileSize, Image.SizeX);
+			const int32 MaxY = FMath::Min(MinY + kMyComputeShaderTileSize, Image.SizeY);
+
+			for (int32 Y = MinY; Y < MaxY; Y++)
+			{
+				for (int32 X = MinX; X < MaxX; X += kMyComputeShaderPixelsPerGroup)
+				{
+					FMyComputeShaderPixels4 Pixels[kMyComputeShaderRegistersPerGroup];
+					EvaluateMyComputeShaderGroup(Constants, X, Y, Pixels);
+
+					const int64 Offset = int64(Y) * Image.SizeX + X;
+					for (int32 Register = 0; Register < kMyComputeShaderRegistersPerGroup; Register++)
+					{
+						// The lanes past the image's right edge are dropped.
+						const int32 NumLanes = MaxX - (X + 4 * Register);
+						if (NumLanes >= 4)
+						{
+							StoreMyComputeShaderPixels(Image, Offset + 4 * Register, Pixels[Register]);
+						}
+						else if (NumLanes > 0)
+						{
+							StoreMyComputeShaderPixelsTail(Image, Offset + 4 * Register, Pixels[Register], NumLanes);
+						}
+					}
+				}
+			}
+		}
+	}, NumWorkers < 2);
+
+	return true;
+}
+
+
+/** Meant for the headless workers, the throughput should scale with the cores up to the memory bandwidth of the stores. */
+static FAutoConsoleCommand GBenchmarkMyComputeShaderCPUCommand(
+	TEXT("ShaderTest.BenchmarkComputeShaderCPU"),
+	TEXT("Times DrawMyComputeShaderToImage_CPU on 1, 2, 4... cores up to all the task graph workers, in Mpix/s.\n")
+	TEXT("Args: [SizeX=1024] [SizeY=1024] [NumSteps=90]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FIntPoint Resolution(
+			Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1024,
+			Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1024);
+		const int32 NumSteps = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 90;
+		const int32 MaxWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+
+		FImage Image(Resolution.X, Resolution.Y, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+
+		// Warms up the task graph workers.
+		DrawMyComputeShaderToImage_CPU(Image, 0.f, 1);
+
+		double SingleCoreMpixPerSecond = 0.0;
+		for (int32 NumWorkers = 1; ; NumWorkers = FMath::Min(NumWorkers * 2, MaxWorkers))
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			DrawMyComputeShaderToImage_CPU(Image, 1.f, NumSteps, NumWorkers);
+			const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+			const double MpixPerSecond = double(Resolution.X) * Resolution.Y / FMath::Max(Seconds, 1.e-6) / 1.e6;
+			SingleCoreMpixPerSecond = NumWorkers == 1 ? MpixPerSecond : SingleCoreMpixPerSecond;
+
+			UE_LOG(LogTemp, Log, TEXT("BenchmarkComputeShaderCPU, %dx%d, %d steps, %d cores: %.2f ms, %.3f Mpix/s, x%.2f"),
+				Resolution.X, Resolution.Y, NumSteps, NumWorkers, Seconds * 1000.0, MpixPerSecond, MpixPerSecond / SingleCoreMpixPerSecond);
+
+			if (NumWorkers == MaxWorkers)
+			{
+				break;
+			}
+		}
+	}));
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FImage;
+
+
+/** Draws the fractal of TestComputeShader.usf into Image on the CPU, for the workers without a GPU (thumbnails, baking).
+ *  The image is split into tiles spread across NumWorkers cores, each tile evaluates 8 pixels at a time in vector registers
+ *  and writes them straight into Image.RawData, which must already be allocated to its size and format.
+ *  @param NumWorkers Cores drawing the tiles, all the task graph workers plus the calling thread when <= 0.
+ *  @return false for the formats other than RGBA32F, RGBA16F and BGRA8.
+ */
+bool DrawMyComputeShaderToImage_CPU(FImage& Image, float GlobalTime, int32 NumSteps, int32 NumWorkers = 0);
@@ -1,77 +1,270 @@
-// #include "ShaderTestLibrary.h"
-// #include "RenderGraphUtils.h"
-// #include "RenderTargetPool.h"
-// #include "ComputerShader/MyComputeShader.h"
-// 
-// TRefCountPtr<IPooledRenderTarget> ComputeShaderOutput;
-// 
-// static void DrawCheckerBoard_RenderThread(
-// 	FRHICommandListImmediate& RHICmdList,
-// 	FTextureRenderTargetResource* TextureRenderTargetResource,
-// 	ERHIFeatureLevel::Type FeatureLevel
-// )
-// {
-// 	//Render Thread Assertion
-// 	check(IsInRenderingThread());
-// 
-// 	//Unbind the previously bound render targets
-// 	//UnbindRenderTargets(RHICmdList);
-// 
-// 	FTexture2DRHIRef RenderTargetTexture = TextureRenderTargetResource->GetRenderTargetTexture();
-// 	
-// 	if (!ComputeShaderOutput.IsValid())
-// 	{
-// 		UE_LOG(LogTemp, Warning, TEXT("Not Valid"));
-// 		FPooledRenderTargetDesc ComputeShaderOutputDesc(FPooledRenderTargetDesc::Create2DDesc(RenderTargetTexture->GetSizeXY(), RenderTargetTexture->GetFormat(), FClearValueBinding::None, TexCreate_None, TexCreate_ShaderResource | TexCreate_UAV, false));
-// 		ComputeShaderOutputDesc.DebugName = TEXT("WhiteNoiseCS_Output_RenderTarget");
-// 		GRenderTargetPool.FindFreeElement(RHICmdList, ComputeShaderOutputDesc, ComputeShaderOutput, TEXT("WhiteNoiseCS_Output_RenderTarget"));
-// 	}
-// 
-// 	//Specify the resource transition, we're executing this in post scene rendering so we set it to Graphics to Compute
-// 	RHICmdList.TransitionResource(EResourceTransitionAccess::ERWBarrier, EResourceTransitionPipeline::EGfxToCompute, ComputeShaderOutput->GetRenderTargetItem().UAV);
-// 
-// 	
-// 
-// 	//Fill the shader parameters structure with tha cached data supplied by the client
-// 	FMyComputeShader::FParameters PassParameters;
-// 	PassParameters.OutputSurface = ComputeShaderOutput->GetRenderTargetItem().UAV;
-// 	PassParameters.TextureSize = RenderTargetTexture->GetSizeXY();
-// 
-// 	//Get a reference to our shader type from global shader map
-// 	TShaderMapRef<FMyComputeShader> MyComputeShader(GetGlobalShaderMap(FeatureLevel));
-// 
-// 	//Dispatch the compute shader
-// 	FComputeShaderUtils::Dispatch(RHICmdList, MyComputeShader, PassParameters,
-// 		FIntVector(FMath::DivideAndRoundUp(PassParameters.TextureSize.X, (float)32),
-// 					FMath::DivideAndRoundUp(PassParameters.TextureSize.Y, (float)32), 1));
-// 
-// 	//Copy shader's output to the render target provided by the client
-// 	RHICmdList.CopyTexture(ComputeShaderOutput->GetRenderTargetItem().ShaderResourceTexture, RenderTargetTexture, FRHICopyTextureInfo());
-// 
-// }
-// 
-// void UShaderTestLibrary::MyComputerShaderDraw(const UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget)
-// {
-// 	check(IsInGameThread());
-// 
-// 	if (!OutputRenderTarget)
-// 	{
-// 		return;
-// 	}
-// 
-// 	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
-// 	ERHIFeatureLevel::Type FeatureLevel = WorldContextObject->GetWorld()->Scene->GetFeatureLevel();
-// 
-// 	ENQUEUE_RENDER_COMMAND(CaptureCommand)
-// 		(
-// 			[TextureRenderTargetResource, FeatureLevel](FRHICommandListImmediate& RHICmdList)
-// 			{
-// 				DrawCheckerBoard_RenderThread
-// 				(
-// 					RHICmdList,
-// 					TextureRenderTargetResource,
-// 					FeatureLevel
-// 				);
-// 			}
-// 	);
-// }
\ No newline at end of file
+#include "ShaderTestLibrary.h"
+#include "ShaderTestPasses.h"
+#include "RenderGraphUtils.h"
+#include "ComputerShader/MyComputeShader.h"
+#include "Common/ShaderTestFrameGraph.h"
+#include "Common/ShaderTestPassProfiler.h"
+
+static TAutoConsoleVariable<int32> CVarComputeShaderNumSteps(
+	TEXT("r.ShaderTest.ComputeShader.NumSteps"),
+	90,
+	TEXT("Ray marching steps per pixel of MyComputerShaderDraw, each step runs 8 fractal iterations."),
+	ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<int32> CVarComputeShaderTileSize(
+	TEXT("r.ShaderTest.ComputeShader.TileSize"),
+	256,
+	TEXT("Size in pixels of the tiles drawn by the progressive MyComputerShaderDraw."),
+	ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<float> CVarComputeShaderBudgetMs(
+	TEXT("r.ShaderTest.ComputeShader.ProgressiveBudgetMs"),
+	2.f,
+	TEXT("GPU time in ms per frame of the progressive MyComputerShaderDraw tiles, measured with timestamps a few frames late."),
+	ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<int32> CVarComputeShaderMaxTilesPerFrame(
+	TEXT("r.ShaderTest.ComputeShader.MaxTilesPerFrame"),
+	16,
+	TEXT("Upper bound of the progressive MyComputerShaderDraw tiles per frame, whatever the budget."),
+	ECVF_RenderThreadSafe);
+
+
+/** Progressive draw of one render target, the image of one time is drawn over several frames. */
+struct FMyComputeShaderProgressiveState
+{
+	/** Keeps the texture from being recycled, only referenced here once the render target is released. */
+	FTexture2DRHIRef Texture;
+	float Time = 0.f;
+	int32 NextTile = 0;
+};
+
+/** Render thread. Splits the per frame tile budget between the progressive draws, from the GPU time of the previous tiles. */
+class FMyComputeShaderTileBudget : public FRenderResource
+{
+public:
+	/** Tiles still allowed this frame. */
+	int32 GetNumTilesLeft()
+	{
+		if (FrameNumber != GFrameNumberRenderThread)
+		{
+			FrameNumber = GFrameNumberRenderThread;
+			NumTilesThisFrame = 0;
+			ReadbackTimings();
+		}
+
+		const int32 MaxTiles = FMath::Max(CVarComputeShaderMaxTilesPerFrame.GetValueOnRenderThread(), 1);
+
+		// Unknown cost, starts with a single tile a frame.
+		int32 NumTiles = 1;
+		if (MsPerTile > 0.f)
+		{
+			NumTiles = FMath::Clamp(FMath::FloorToInt(CVarComputeShaderBudgetMs.GetValueOnRenderThread() / MsPerTile), 1, MaxTiles);
+		}
+		return FMath::Max(NumTiles - NumTilesThisFrame, 0);
+	}
+
+	/** Adds the passes of NumTiles tiles with AddTilePasses(), between two timestamps. */
+	void AddTimedTilePasses(FRDGBuilder& GraphBuilder, int32 NumTiles, TFunctionRef<void()> AddTilePasses)
+	{
+		NumTilesThisFrame += NumTiles;
+
+		FTimedTiles& TimedTiles = PendingTimings.AddDefaulted_GetRef();
+		TimedTiles.Begin = FShaderTestPassProfiler::AllocateTimestampQuery();
+		TimedTiles.End = FShaderTestPassProfiler::AllocateTimestampQuery();
+		TimedTiles.NumTiles = NumTiles;
+
+		AddTimestampPass(GraphBuilder, TimedTiles.Begin.GetQuery());
+		AddTilePasses();
+		AddTimestampPass(GraphBuilder, TimedTiles.End.GetQuery());
+	}
+
+	// FRenderResource interface.
+	virtual void ReleaseRHI() override
+	{
+		// The queries go back to the pool of the profiler.
+		PendingTimings.Empty();
+	}
+
+private:
+	struct FTimedTiles
+	{
+		FRHIPooledRenderQuery Begin;
+		FRHIPooledRenderQuery End;
+		int32 NumTiles = 0;
+	};
+
+	static void AddTimestampPass(FRDGBuilder& GraphBuilder, FRHIRenderQuery* Query)
+	{
+		GraphBuilder.AddPass(
+			RDG_EVENT_NAME("MyComputeShaderTimestamp"),
+			ERDGPassFlags::NeverCull,
+			[Query](FRHICommandListImmediate& RHICmdList)
+			{
+				RHICmdList.EndRenderQuery(Query);
+			});
+	}
+
+	/** Reads the timings of the frames the GPU is done with, without waiting. */
+	void ReadbackTimings()
+	{
+		while (PendingTimings.Num() > 0)
+		{
+			// Microseconds.
+			uint64 Begin = 0;
+			uint64 End = 0;
+			if (!RHIGetRenderQueryResult(PendingTimings[0].Begin.GetQuery(), Begin, false) || !RHIGetRenderQueryResult(PendingTimings[0].End.GetQuery(), End, false))
+			{
+				break;
+			}
+
+			const float Ms = float(End - Begin) / 1000.f / float(PendingTimings[0].NumTiles);
+			MsPerTile = MsPerTile > 0.f ? FMath::Lerp(MsPerTile, Ms, 0.25f) : Ms;
+			PendingTimings.RemoveAt(0);
+		}
+	}
+
+	TArray<FTimedTiles> PendingTimings;
+	float MsPerTile = 0.f;
+	uint32 FrameNumber = 0;
+	int32 NumTilesThisFrame = 0;
+};
+
+static TMap<FRHITexture*, FMyComputeShaderProgressiveState> GProgressiveStates;
+static TGlobalResource<FMyComputeShaderTileBudget> GTileBudget;
+
+static void AddMyComputeShaderTilePass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureUAVRef OutputUAV,
+	float Time,
+	FIntRect Rect)
+{
+	FMyComputeShader::FParameters* PassParameters = GraphBuilder.AllocParameters<FMyComputeShader::FParameters>();
+	PassParameters->GlobalTime = Time;
+	PassParameters->NumSteps = FMath::Max(CVarComputeShaderNumSteps.GetValueOnRenderThread(), 1);
+	PassParameters->TileOffset = Rect.Min;
+	PassParameters->OutputSize = OutputUAV->Desc.Texture->Desc.Extent;
+	PassParameters->OutputSurface = OutputUAV;
+
+	TShaderMapRef<FMyComputeShader> MyComputeShader(GetGlobalShaderMap(FeatureLevel));
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("MyComputeShader %dx%d", Rect.Width(), Rect.Height()),
+		MyComputeShader,
+		PassParameters,
+		FComputeShaderUtils::GetGroupCount(Rect.Size(), FMyComputeShader::kThreadGroupSize));
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::ComputeShader, 1);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::ComputeShader, sizeof(FMyComputeShader::FParameters));
+}
+
+void AddMyComputeShaderPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	float Time)
+{
+	SHADERTEST_PASS_SCOPE(ComputeShader, RenderThread);
+	SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, ComputeShader);
+
+	AddMyComputeShaderTilePass(GraphBuilder, FeatureLevel, GraphBuilder.CreateUAV(OutputTexture), Time, FIntRect(FIntPoint::ZeroValue, OutputTexture->Desc.Extent));
+}
+
+static void AddMyComputeShaderPasses(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRHITexture2D* RenderTargetTexture,
+	float Time,
+	bool bProgressive)
+{
+	// Forgets the render targets only referenced by their progressive state.
+	for (TMap<FRHITexture*, FMyComputeShaderProgressiveState>::TIterator It = GProgressiveStates.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Texture->GetRefCount() == 1)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("MyComputeShaderOutput")));
+	FRDGTextureUAVRef OutputUAV = GraphBuilder.CreateUAV(OutputTexture);
+	GraphBuilder.SetTextureAccessFinal(OutputTexture, ERHIAccess::SRVMask);
+
+	const FIntPoint Resolution = RenderTargetTexture->GetSizeXY();
+
+	if (!bProgressive)
+	{
+		GProgressiveStates.Remove(RenderTargetTexture);
+		AddMyComputeShaderTilePass(GraphBuilder, FeatureLevel, OutputUAV, Time, FIntRect(FIntPoint::ZeroValue, Resolution));
+		return;
+	}
+
+	const int32 TileSize = FMath::Max(CVarComputeShaderTileSize.GetValueOnRenderThread(), FMyComputeShader::kThreadGroupSize);
+	const FIntPoint NumTilesXY = FIntPoint::DivideAndRoundUp(Resolution, TileSize);
+	const int32 NumTiles = NumTilesXY.X * NumTilesXY.Y;
+
+	FMyComputeShaderProgressiveState& State = GProgressiveStates.FindOrAdd(RenderTargetTexture);
+	if (!State.Texture || State.NextTile >= NumTiles)
+	{
+		// Starts the next image, the time is latched until all its tiles are drawn.
+		State.Texture = RenderTargetTexture;
+		State.Time = Time;
+		State.NextTile = 0;
+	}
+
+	const int32 NumTilesToDraw = FMath::Min(GTileBudget.GetNumTilesLeft(), NumTiles - State.NextTile);
+	if (NumTilesToDraw == 0)
+	{
+		return;
+	}
+
+	GTileBudget.AddTimedTilePasses(GraphBuilder, NumTilesToDraw, [&]()
+	{
+		for (int32 Index = 0; Index < NumTilesToDraw; Index++, State.NextTile++)
+		{
+			const FIntPoint TileMin(State.NextTile % NumTilesXY.X * TileSize, State.NextTile / NumTilesXY.X * TileSize);
+			const FIntRect Tile(TileMin, FIntPoint(FMath::Min(TileMin.X + TileSize, Resolution.X), FMath::Min(TileMin.Y + TileSize, Resolution.Y)));
+			AddMyComputeShaderTilePass(GraphBuilder, FeatureLevel, OutputUAV, State.Time, Tile);
+		}
+	});
+}
+
+void UShaderTestLibrary::MyComputerShaderDraw(const UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget, float Time, bool bProgressive)
+{
+	check(IsInGameThread());
+
+	if (!OutputRenderTarget || !WorldContextObject)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::MyComputerShaderDraw, param error"));
+		return;
+	}
+
+	if (!OutputRenderTarget->bCanCreateUAV)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::MyComputerShaderDraw, %s needs bCanCreateUAV"), *OutputRenderTarget->GetName());
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(ComputeShader, GameThread);
+
+	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
+	ERHIFeatureLevel::Type FeatureLevel = WorldContextObject->GetWorld()->Scene->GetFeatureLevel();
+
+	ENQUEUE_RENDER_COMMAND(CaptureCommand)
+		(
+			[TextureRenderTargetResource, FeatureLevel, Time, bProgressive](FRHICommandListImmediate& RHICmdList)
+			{
+				SHADERTEST_PASS_SCOPE(ComputeShader, RenderThread);
+
+				FTexture2DRHIRef RenderTargetTexture = TextureRenderTargetResource->GetRenderTargetTexture();
+
+				FShaderTestFrameGraph::AddPasses(RHICmdList, [RenderTargetTexture, FeatureLevel, Time, bProgressive](FRDGBuilder& GraphBuilder)
+				{
+					SHADERTEST_PASS_SCOPE(ComputeShader, RenderThread);
+					SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, ComputeShader);
+					AddMyComputeShaderPasses(GraphBuilder, FeatureLevel, RenderTargetTexture, Time, bProgressive);
+				});
+			}
+	);
+}
@@ -1,7 +1,11 @@
 ﻿#include "ShaderTestLibrary.h"
+#include "ShaderTestPasses.h"
 #include "RenderGraphUtils.h"
 #include "FirstShader/FirstShader.h"
 #include "Common/TestShaderUtils.h"
+#include "Common/ShaderTestFrameGraph.h"
+#include "Common/ShaderTestPassProfiler.h"
+#include "PipelineStateCache.h"
 
 static void ExecuteFirstShader(FRHICommandList& RHICmdList, ERHIFeatureLevel::Type FeatureLevel, FFirstShaderPS::FParameters* ShaderParamters)
 {
@@ -16,45 +20,14 @@ static void ExecuteFirstShader(FRHICommandList& RHICmdList, ERHIFeatureLevel::Ty
 	GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
 	GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
 	GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
-	GraphicsPSOInit.PrimitiveType = PT_TriangleList;
-	GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GetVertexDeclarationFVector4();
 	GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
 	GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+	UTestShaderUtils::SetupFullScreenTriangle(GraphicsPSOInit);
 	SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
 
 	SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), *ShaderParamters);
 
-	static const uint32 VERTEX_SIZE = sizeof(FVector4f) * 4;
-	FRHIResourceCreateInfo CreateInfo(TEXT("FirstShader"));
-	FBufferRHIRef VertexBufferRHI = RHICreateVertexBuffer(VERTEX_SIZE, BUF_Static, CreateInfo);
-	FVector4f* VerticesPtr = reinterpret_cast<FVector4f*>(RHILockBuffer(VertexBufferRHI, 0, VERTEX_SIZE, RLM_WriteOnly));
-
-	VerticesPtr[0].Set(-1.0f, 1.0f, 0, 1.0f);
-	VerticesPtr[1].Set(1.0f, 1.0f, 0, 1.0f);
-	VerticesPtr[2].Set(-1.0f, -1.0f, 0, 1.0f);
-	VerticesPtr[3].Set(1.0f, -1.0f, 0, 1.0f);
-
-	RHIUnlockBuffer(VertexBufferRHI);
-	RHICmdList.SetStreamSource(0, VertexBufferRHI, 0);
-
-	//顶点索引
-	TArray<uint16, TInlineAllocator<6> > IndexList({ 0, 1, 2, 2, 1, 3 });
-	int IndexSize = sizeof(uint16) * IndexList.Num();
-
-	FBufferRHIRef IndexBufferRHI = RHICreateIndexBuffer(sizeof(uint16), IndexSize, BUF_Volatile, CreateInfo);
-	void* VoidPtr2 = RHILockBuffer(IndexBufferRHI, 0, IndexSize, RLM_WriteOnly);
-	FPlatformMemory::Memcpy(VoidPtr2, IndexList.GetData(), IndexSize);
-	RHIUnlockBuffer(IndexBufferRHI);
-
-	RHICmdList.DrawIndexedPrimitive(
-		IndexBufferRHI,
-		0, /*BaseVertexIndex*/
-		0, /*MinIndex*/
-		4, /*NumVertices*/
-		0, /*StartIndex*/
-		2, /*NumPrimitives*/
-		1  /*NumInstances*/
-	);
+	UTestShaderUtils::DrawFullScreenTriangle(RHICmdList);
 }
 
 static void FirstShader_RenderThread(
@@ -75,6 +48,13 @@ static void FirstShader_RenderThread(
 	SCOPED_DRAW_EVENT(RHICmdList, FirstShader_RenderThread);
 #endif
 
+	// Draws after the RDG calls enqueued before this one.
+	FShaderTestFrameGraph::Flush(RHICmdList);
+
+	// After the flush, which is timed by the entry points it records.
+	SHADERTEST_PASS_SCOPE(FirstShader, RenderThread);
+	SHADERTEST_RHI_GPU_SCOPE(RHICmdList, FirstShader);
+
 	FRHITexture2D* RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
 
 	FRHIRenderPassInfo RPInfo(RenderTargetTexture, ERenderTargetActions::DontLoad_Store);
@@ -92,24 +72,23 @@ static void FirstShader_RenderThread(
 	}
 
 	RHICmdList.EndRenderPass();
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::FirstShader, 1);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::FirstShader, sizeof(FLinearColor));
 }
 
-static void FirstShader_RDG_RenderThread(
-	FRHICommandListImmediate& RHICmdList,
-	FTextureRenderTargetResource* OutTextureRenderTargetResource,
+void AddFirstShaderPass(
+	FRDGBuilder& GraphBuilder,
 	ERHIFeatureLevel::Type FeatureLevel,
-	FName TextureRenderTargetName,
-	FLinearColor MyColor
-)
+	FRDGTextureRef OutputTexture,
+	FLinearColor Color)
 {
-	FRDGBuilder GraphBuilder(RHICmdList);
-
-	TRefCountPtr<IPooledRenderTarget> PooledRenderTarget = CreateRenderTarget(OutTextureRenderTargetResource->GetRenderTargetTexture(), TEXT("First_RDG_RT"));
-	FRDGTextureRef RDGRenderTarget = GraphBuilder.RegisterExternalTexture(PooledRenderTarget);
+	SHADERTEST_PASS_SCOPE(FirstShader, RenderThread);
+	SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, FirstShader);
 
 	FFirstShaderPS::FParameters* Parameters = GraphBuilder.AllocParameters<FFirstShaderPS::FParameters>();
-	Parameters->SimpleColor = MyColor;
-	Parameters->RenderTargets[0] = FRenderTargetBinding(RDGRenderTarget, ERenderTargetLoadAction::ENoAction);
+	Parameters->SimpleColor = Color;
+	Parameters->RenderTargets[0] = FRenderTargetBinding(OutputTexture, ERenderTargetLoadAction::ENoAction);
 
 	GraphBuilder.AddPass(
 		RDG_EVENT_NAME("FirstShader_RDG_RenderThread"),
@@ -120,8 +99,242 @@ static void FirstShader_RDG_RenderThread(
 			ExecuteFirstShader(RHICmdList, FeatureLevel, Parameters);
 		});
 
-	GraphBuilder.QueueTextureExtraction(RDGRenderTarget, &PooledRenderTarget);
-	GraphBuilder.Execute();
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::FirstShader, 1);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::FirstShader, sizeof(FLinearColor));
+}
+
+static void FirstShader_RDG_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FTextureRenderTargetResource* OutTextureRenderTargetResource,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FName TextureRenderTargetName,
+	FLinearColor MyColor
+)
+{
+	SHADERTEST_PASS_SCOPE(FirstShader, RenderThread);
+
+	FTexture2DRHIRef RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
+
+	FShaderTestFrameGraph::AddPasses(RHICmdList, [RenderTargetTexture, FeatureLevel, MyColor](FRDGBuilder& GraphBuilder)
+	{
+		FRDGTextureRef RDGRenderTarget = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("First_RDG_RT")));
+
+		AddFirstShaderPass(GraphBuilder, FeatureLevel, RDGRenderTarget, MyColor);
+
+		GraphBuilder.SetTextureAccessFinal(RDGRenderTarget, ERHIAccess::SRVMask);
+	});
+}
+
+/** One render target of a batched fill. */
+struct FFirstShaderBatchItem
+{
+	FTextureRenderTargetResource* RenderTargetResource;
+	FLinearColor Color;
+};
+
+/** FirstShader pipeline state for one render target format, looked up once and bound by every target of that format.
+ *  PipelineState is null when the pipeline state cache could not create it, the targets of that format are then skipped.
+ */
+struct FFirstShaderPipelineState
+{
+	FGraphicsPipelineState* PipelineState = nullptr;
+	FBoundShaderStateInput BoundShaderState;
+	TShaderRef<FFirstShaderPS> PixelShader;
+};
+
+static bool IsSameRenderTargetFormat(FRHITexture* A, FRHITexture* B)
+{
+	return A->GetFormat() == B->GetFormat() && A->GetFlags() == B->GetFlags() && A->GetNumSamples() == B->GetNumSamples();
+}
+
+static FFirstShaderPipelineState GetFirstShaderPipelineState(FRHICommandList& RHICmdList, ERHIFeatureLevel::Type FeatureLevel, FRHITexture* RenderTargetTexture)
+{
+	FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+	TShaderMapRef<FFirstShaderVS> VertexShader(GlobalShaderMap);
+	TShaderMapRef<FFirstShaderPS> PixelShader(GlobalShaderMap);
+
+	// Render target layout is set explicitly, so the lookup can be done outside of the render passes.
+	FGraphicsPipelineStateInitializer GraphicsPSOInit;
+	GraphicsPSOInit.RenderTargetsEnabled = 1;
+	GraphicsPSOInit.RenderTargetFormats[0] = RenderTargetTexture->GetFormat();
+	GraphicsPSOInit.RenderTargetFlags[0] = RenderTargetTexture->GetFlags();
+	GraphicsPSOInit.NumSamples = RenderTargetTexture->GetNumSamples();
+	GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+	GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+	GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+	GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+	GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+	UTestShaderUtils::SetupFullScreenTriangle(GraphicsPSOInit);
+
+	FFirstShaderPipelineState Result;
+	Result.PipelineState = PipelineStateCache::GetAndOrCreateGraphicsPipelineState(RHICmdList, GraphicsPSOInit, EApplyRendertargetOption::DoNothing);
+	Result.BoundShaderState = GraphicsPSOInit.BoundShaderState;
+	Result.PixelShader = PixelShader;
+	return Result;
+}
+
+static void LogMissingFirstShaderPipelineState(FRHITexture* RenderTargetTexture)
+{
+	UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::FirstShaderDrawRenderTargets, no pipeline state for the format %s, its render targets are skipped"),
+		GPixelFormats[RenderTargetTexture->GetFormat()].Name);
+}
+
+static void DrawFirstShader(FRHICommandList& RHICmdList, const FFirstShaderPipelineState& PipelineState, FIntPoint Resolution, const FFirstShaderPS::FParameters& ShaderParameters)
+{
+	RHICmdList.SetViewport(0, 0, 0.f, Resolution.X, Resolution.Y, 1.f);
+	RHICmdList.SetGraphicsPipelineState(PipelineState.PipelineState, PipelineState.BoundShaderState, 0, false);
+
+	SetShaderParameters(RHICmdList, PipelineState.PixelShader, PipelineState.PixelShader.GetPixelShader(), ShaderParameters);
+
+	UTestShaderUtils::DrawFullScreenTriangle(RHICmdList);
+}
+
+/** Sorts the batch so that the render targets sharing a format are contiguous. */
+static void SortFirstShaderBatchByFormat(TArray<FFirstShaderBatchItem>& Items)
+{
+	Items.StableSort([](const FFirstShaderBatchItem& A, const FFirstShaderBatchItem& B)
+	{
+		FRHITexture* TextureA = A.RenderTargetResource->GetRenderTargetTexture();
+		FRHITexture* TextureB = B.RenderTargetResource->GetRenderTargetTexture();
+		if (TextureA->GetFormat() != TextureB->GetFormat())
+		{
+			return TextureA->GetFormat() < TextureB->GetFormat();
+		}
+		if (TextureA->GetFlags() != TextureB->GetFlags())
+		{
+			return uint64(TextureA->GetFlags()) < uint64(TextureB->GetFlags());
+		}
+		return TextureA->GetNumSamples() < TextureB->GetNumSamples();
+	});
+}
+
+static void FirstShaderBatch_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	TArray<FFirstShaderBatchItem>& Items,
+	ERHIFeatureLevel::Type FeatureLevel
+)
+{
+	check(IsInRenderingThread());
+
+	SCOPED_DRAW_EVENTF(RHICmdList, FirstShaderBatch, TEXT("FirstShaderBatch %d targets"), Items.Num());
+
+	// Draws after the RDG calls enqueued before this one.
+	FShaderTestFrameGraph::Flush(RHICmdList);
+
+	SHADERTEST_PASS_SCOPE(FirstShader, RenderThread);
+	SHADERTEST_RHI_GPU_SCOPE(RHICmdList, FirstShader);
+
+	SortFirstShaderBatchByFormat(Items);
+
+	FRHITexture* PipelineStateTexture = nullptr;
+	FFirstShaderPipelineState PipelineState;
+	int32 NumDraws = 0;
+
+	for (const FFirstShaderBatchItem& Item : Items)
+	{
+		FRHITexture2D* RenderTargetTexture = Item.RenderTargetResource->GetRenderTargetTexture();
+		if (!PipelineStateTexture || !IsSameRenderTargetFormat(PipelineStateTexture, RenderTargetTexture))
+		{
+			PipelineStateTexture = RenderTargetTexture;
+			PipelineState = GetFirstShaderPipelineState(RHICmdList, FeatureLevel, RenderTargetTexture);
+			if (!PipelineState.PipelineState)
+			{
+				LogMissingFirstShaderPipelineState(RenderTargetTexture);
+			}
+		}
+
+		if (!PipelineState.PipelineState)
+		{
+			continue;
+		}
+
+		FFirstShaderPS::FParameters ShaderParameters;
+		ShaderParameters.SimpleColor = Item.Color;
+
+		FRHIRenderPassInfo RPInfo(RenderTargetTexture, ERenderTargetActions::DontLoad_Store);
+		RHICmdList.BeginRenderPass(RPInfo, TEXT("FirstShaderBatch_Pass"));
+		DrawFirstShader(RHICmdList, PipelineState, RenderTargetTexture->GetSizeXY(), ShaderParameters);
+		RHICmdList.EndRenderPass();
+		NumDraws++;
+	}
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::FirstShader, NumDraws);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::FirstShader, NumDraws * sizeof(FLinearColor));
+}
+
+static void FirstShaderBatch_RDG_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	TArray<FFirstShaderBatchItem>& Items,
+	ERHIFeatureLevel::Type FeatureLevel
+)
+{
+	check(IsInRenderingThread());
+
+	SHADERTEST_PASS_SCOPE(FirstShader, RenderThread);
+
+	SortFirstShaderBatchByFormat(Items);
+
+	// The render target resources may be released before the frame graph is flushed.
+	TArray<TPair<FTexture2DRHIRef, FLinearColor>> Targets;
+	Targets.Reserve(Items.Num());
+	for (const FFirstShaderBatchItem& Item : Items)
+	{
+		Targets.Emplace(Item.RenderTargetResource->GetRenderTargetTexture(), Item.Color);
+	}
+
+	FShaderTestFrameGraph::AddPasses(RHICmdList, [Targets = MoveTemp(Targets), FeatureLevel](FRDGBuilder& GraphBuilder)
+	{
+		SHADERTEST_PASS_SCOPE(FirstShader, RenderThread);
+		SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, FirstShader);
+		RDG_EVENT_SCOPE(GraphBuilder, "FirstShaderBatch %d targets", Targets.Num());
+
+		FRHITexture* PipelineStateTexture = nullptr;
+		const FFirstShaderPipelineState* PipelineState = nullptr;
+		int32 NumDraws = 0;
+
+		for (const TPair<FTexture2DRHIRef, FLinearColor>& Target : Targets)
+		{
+			FRHITexture2D* RenderTargetTexture = Target.Key;
+
+			// Resolved while building the graph, the passes may be recorded in parallel.
+			if (!PipelineStateTexture || !IsSameRenderTargetFormat(PipelineStateTexture, RenderTargetTexture))
+			{
+				PipelineStateTexture = RenderTargetTexture;
+				PipelineState = GraphBuilder.AllocObject<FFirstShaderPipelineState>(GetFirstShaderPipelineState(GraphBuilder.RHICmdList, FeatureLevel, RenderTargetTexture));
+				if (!PipelineState->PipelineState)
+				{
+					LogMissingFirstShaderPipelineState(RenderTargetTexture);
+				}
+			}
+
+			if (!PipelineState->PipelineState)
+			{
+				continue;
+			}
+
+			FRDGTextureRef RDGRenderTarget = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("FirstBatch_RDG_RT")));
+
+			FFirstShaderPS::FParameters* Parameters = GraphBuilder.AllocParameters<FFirstShaderPS::FParameters>();
+			Parameters->SimpleColor = Target.Value;
+			Parameters->RenderTargets[0] = FRenderTargetBinding(RDGRenderTarget, ERenderTargetLoadAction::ENoAction);
+
+			const FIntPoint Resolution = RenderTargetTexture->GetSizeXY();
+			GraphBuilder.AddPass(
+				RDG_EVENT_NAME("FirstShaderBatch_Pass"),
+				Parameters,
+				ERDGPassFlags::Raster,
+				[PipelineState, Resolution, Parameters](FRHICommandList& RHICmdList)
+				{
+					DrawFirstShader(RHICmdList, *PipelineState, Resolution, *Parameters);
+				});
+
+			GraphBuilder.SetTextureAccessFinal(RDGRenderTarget, ERHIAccess::SRVMask);
+			NumDraws++;
+		}
+
+		FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::FirstShader, NumDraws);
+		FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::FirstShader, NumDraws * sizeof(FLinearColor));
+	});
 }
 
 void UShaderTestLibrary::FirstShaderDrawRenderTarget(UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget, FLinearColor MyColor, bool UsingRDG)
@@ -134,6 +347,8 @@ void UShaderTestLibrary::FirstShaderDrawRenderTarget(UObject* WorldContextObject
 		return;
 	}
 
+	SHADERTEST_PASS_SCOPE(FirstShader, GameThread);
+
 	UE_LOG(LogTemp, Log, TEXT("UShaderTestLibrary::FirstShaderDrawRenderTarget, sizeof(FVector4):%d, sizeof(FVector4f):%d"), sizeof(FVector4), sizeof(FVector4f));
 
 	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
@@ -155,3 +370,49 @@ void UShaderTestLibrary::FirstShaderDrawRenderTarget(UObject* WorldContextObject
 	);
 }
 
+
+
+void UShaderTestLibrary::FirstShaderDrawRenderTargets(UObject* WorldContextObject, const TArray<UTextureRenderTarget2D*>& OutputRenderTargets, const TArray<FLinearColor>& MyColors, bool UsingRDG)
+{
+	check(IsInGameThread());
+
+	if (!WorldContextObject || (MyColors.Num() != 1 && MyColors.Num() != OutputRenderTargets.Num()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::FirstShaderDrawRenderTargets, param error"));
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(FirstShader, GameThread);
+
+	TArray<FFirstShaderBatchItem> Items;
+	Items.Reserve(OutputRenderTargets.Num());
+	for (int32 Index = 0; Index < OutputRenderTargets.Num(); Index++)
+	{
+		if (OutputRenderTargets[Index])
+		{
+			FFirstShaderBatchItem& Item = Items.AddDefaulted_GetRef();
+			Item.RenderTargetResource = OutputRenderTargets[Index]->GameThread_GetRenderTargetResource();
+			Item.Color = MyColors.Num() == 1 ? MyColors[0] : MyColors[Index];
+		}
+	}
+
+	if (Items.Num() == 0)
+	{
+		return;
+	}
+
+	ERHIFeatureLevel::Type FeatureLevel = WorldContextObject->GetWorld()->Scene->GetFeatureLevel();
+	ENQUEUE_RENDER_COMMAND(CaptureCommand)(
+		[Items = MoveTemp(Items), FeatureLevel, UsingRDG](FRHICommandListImmediate& RHICmdList) mutable
+		{
+			if (UsingRDG)
+			{
+				FirstShaderBatch_RDG_RenderThread(RHICmdList, Items, FeatureLevel);
+			}
+			else
+			{
+				FirstShaderBatch_RenderThread(RHICmdList, Items, FeatureLevel);
+			}
+		}
+	);
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LensDistortionAnimatedDisplacement.h"
+#include "Common/ShaderTestStats.h"
+#include "Common/ShaderTestPassProfiler.h"
+
+#include "RenderTargetPool.h"
+#include "RenderGraphUtils.h"
+
+
+static TAutoConsoleVariable<float> CVarAnimatedDisplacementEpsilon(
+	TEXT("r.ShaderTest.LensDistortion.AnimatedEpsilon"),
+	1.e-5f,
+	TEXT("Largest change of the compiled camera model parameters (K1 to P2, camera matrices, output multiply and add) for which\n")
+	TEXT("an animated lens keeps its displacement map instead of generating a new one."),
+	ECVF_RenderThreadSafe);
+
+TGlobalResource<FLensDistortionAnimatedDisplacement> GLensDistortionAnimatedDisplacement;
+
+
+void FLensDistortionAnimatedDisplacement::AddDrawUVDisplacementPasses(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FCompiledCameraModel& CompiledCameraModel,
+	FRHITexture2D* RenderTargetTexture,
+	TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement)
+{
+	check(IsInRenderingThread());
+
+	ForgetReleasedRenderTargets();
+
+	const FIntPoint Resolution = RenderTargetTexture->GetSizeXY();
+	const EPixelFormat Format = RenderTargetTexture->GetFormat();
+	const ETextureCreateFlags SRGBFlags = RenderTargetTexture->GetFlags() & TexCreate_SRGB;
+	const bool bUseCompute = CanWriteUVDisplacementWithCompute(Format, SRGBFlags != TexCreate_None);
+
+	FRenderTargetState& State = RenderTargetStates.FindOrAdd(RenderTargetTexture);
+
+	// New or resized render target.
+	if (!State.Maps[0] || State.Maps[0]->GetDesc().Extent != Resolution || State.Maps[0]->GetDesc().Format != Format
+		|| (State.Maps[0]->GetDesc().Flags & TexCreate_SRGB) != SRGBFlags)
+	{
+		ReleaseState(State);
+		State.RenderTarget = RenderTargetTexture;
+
+		// The sRGB maps are encoded like the render target, so that their copy into it decodes back to the displacements.
+		FPooledRenderTargetDesc Desc(FPooledRenderTargetDesc::Create2DDesc(
+			Resolution, Format, FClearValueBinding::None, SRGBFlags,
+			TexCreate_ShaderResource | (bUseCompute ? TexCreate_UAV : TexCreate_RenderTargetable), false));
+		for (TRefCountPtr<IPooledRenderTarget>& Map : State.Maps)
+		{
+			GRenderTargetPool.FindFreeElement(GraphBuilder.RHICmdList, Desc, Map, TEXT("LensDistortionAnimatedDisplacement"));
+		}
+
+		State.SizeInBytes = 2 * uint64(Resolution.X) * Resolution.Y * GPixelFormats[Format].BlockBytes;
+		INC_MEMORY_STAT_BY(STAT_ShaderTest_AnimatedDisplacementMemory, State.SizeInBytes);
+	}
+
+	if (State.bBackPending)
+	{
+		State.Front = 1 - State.Front;
+		State.FrontCameraModel = State.BackCameraModel;
+		State.bBackPending = false;
+	}
+
+	const float Epsilon = FMath::Max(CVarAnimatedDisplacementEpsilon.GetValueOnRenderThread(), 0.0f);
+
+	if (!State.bHasFront)
+	{
+		// Nothing to show yet, the first map is generated on the graphics pipe before the copy.
+		FRDGTextureRef FrontMap = GraphBuilder.RegisterExternalTexture(State.Maps[State.Front]);
+		if (bUseCompute)
+		{
+			AddLensDistortionUVDisplacementPass(GraphBuilder, FeatureLevel, CompiledCameraModel, FrontMap);
+		}
+		else
+		{
+			GenerateDisplacement(FrontMap);
+		}
+		State.FrontCameraModel = CompiledCameraModel;
+		State.bHasFront = true;
+		INC_DWORD_STAT(STAT_ShaderTest_AnimatedDisplacementUpdates);
+	}
+	else if (State.FrontCameraModel.GetMaxParameterDifference(CompiledCameraModel) > Epsilon)
+	{
+		// Overlaps with the copy of the front map and the rest of the graph, the raster passes still run on the graphics pipe.
+		FRDGTextureRef BackMap = GraphBuilder.RegisterExternalTexture(State.Maps[1 - State.Front]);
+		if (bUseCompute)
+		{
+			AddLensDistortionUVDisplacementPass(GraphBuilder, FeatureLevel, CompiledCameraModel, BackMap, ERDGPassFlags::AsyncCompute);
+		}
+		else
+		{
+			GenerateDisplacement(BackMap);
+		}
+		State.BackCameraModel = CompiledCameraModel;
+		State.bBackPending = true;
+		INC_DWORD_STAT(STAT_ShaderTest_AnimatedDisplacementUpdates);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_ShaderTest_AnimatedDisplacementSkips);
+	}
+
+	FRDGTextureRef RenderTarget = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("LensDistortionDisplacement")));
+	GraphBuilder.SetTextureAccessFinal(RenderTarget, ERHIAccess::SRVMask);
+
+	AddCopyTexturePass(GraphBuilder, GraphBuilder.RegisterExternalTexture(State.Maps[State.Front]), RenderTarget);
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+}
+
+
+void FLensDistortionAnimatedDisplacement::Empty()
+{
+	for (TPair<FRHITexture*, FRenderTargetState>& Pair : RenderTargetStates)
+	{
+		ReleaseState(Pair.Value);
+	}
+	RenderTargetStates.Empty();
+}
+
+
+void FLensDistortionAnimatedDisplacement::ReleaseRHI()
+{
+	Empty();
+}
+
+
+void FLensDistortionAnimatedDisplacement::ForgetReleasedRenderTargets()
+{
+	for (TMap<FRHITexture*, FRenderTargetState>::TIterator It = RenderTargetStates.CreateIterator(); It; ++It)
+	{
+		// Only referenced by this, the render target has been released or resized.
+		if (It.Value().RenderTarget->GetRefCount() == 1)
+		{
+			ReleaseState(It.Value());
+			It.RemoveCurrent();
+		}
+	}
+}
+
+
+void FLensDistortionAnimatedDisplacement::ReleaseState(FRenderTargetState& State)
+{
+	DEC_MEMORY_STAT_BY(STAT_ShaderTest_AnimatedDisplacementMemory, State.SizeInBytes);
+	State = FRenderTargetState();
+}
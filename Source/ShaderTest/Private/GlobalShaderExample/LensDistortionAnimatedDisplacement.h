@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderResource.h"
+#include "RendererInterface.h"
+#include "LensDistortionRendering.h"
+
+
+/**
+ * Render thread double buffered displacement maps of the render targets drawn with an animated camera model,
+ * such as the focus and zoom of a lens animated by Sequencer.
+ *
+ * Each render target has a front map, the one copied into it, and a back map generated on async compute with the latest
+ * camera model while the front one is used. The back map becomes the front one on the next draw, so the render target lags
+ * one draw behind the camera model while it moves. Camera models within r.ShaderTest.LensDistortion.AnimatedEpsilon of the
+ * latest generated one are skipped. The displacement cache is not used, an animated model seldom comes back.
+ *
+ * The first map of a render target has no front map to show meanwhile, so it is generated synchronously on the graphics
+ * pipe before its copy. The front map is copied on every draw, other draws may have written the render target since.
+ * The maps the compute pass can't write, see CanWriteUVDisplacementWithCompute(), are drawn on the graphics pipe instead.
+ */
+class FLensDistortionAnimatedDisplacement : public FRenderResource
+{
+public:
+	/** Adds the passes copying the front map into the render target and generating the back map of this camera model,
+	 *  calling GenerateDisplacement(Texture) to add the raster passes drawing a map the compute pass can't write.
+	 */
+	void AddDrawUVDisplacementPasses(
+		FRDGBuilder& GraphBuilder,
+		ERHIFeatureLevel::Type FeatureLevel,
+		const FCompiledCameraModel& CompiledCameraModel,
+		FRHITexture2D* RenderTargetTexture,
+		TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement);
+
+	/** Forgets the maps of every render target. */
+	void Empty();
+
+	// FRenderResource interface.
+	virtual void ReleaseRHI() override;
+
+private:
+	struct FRenderTargetState
+	{
+		/** The reference keeps the render target from being recycled into another texture at the same address. */
+		FTextureRHIRef RenderTarget;
+
+		TRefCountPtr<IPooledRenderTarget> Maps[2];
+		uint64 SizeInBytes = 0;
+
+		/** Index of the front map in Maps, valid once bHasFront. */
+		int32 Front = 0;
+		bool bHasFront = false;
+		FCompiledCameraModel FrontCameraModel;
+
+		/** The back map was generated by the previous draw, it becomes the front one on the next. */
+		bool bBackPending = false;
+		FCompiledCameraModel BackCameraModel;
+	};
+
+	void ForgetReleasedRenderTargets();
+	void ReleaseState(FRenderTargetState& State);
+
+	TMap<FRHITexture*, FRenderTargetState> RenderTargetStates;
+};
+
+extern TGlobalResource<FLensDistortionAnimatedDisplacement> GLensDistortionAnimatedDisplacement;
@@ -1,6 +1,11 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "LensDistortionBlueprintLibrary.h"
+#include "LensDistortionCPU.h"
+#include "LensDistortionSceneViewExtension.h"
+#include "Common/ShaderTestFrameGraph.h"
+
+#include "Engine/TextureRenderTarget2D.h"
 
 
 PRAGMA_DISABLE_DEPRECATION_WARNINGS
@@ -14,9 +19,10 @@ void ULensDistortionBlueprintLibrary::GetUndistortOverscanFactor(
 	const FFooCameraModel& CameraModel,
 	float DistortedHorizontalFOV,
 	float DistortedAspectRatio,
-	float& UndistortOverscanFactor)
+	float& UndistortOverscanFactor,
+	bool bPrecise)
 {
-	UndistortOverscanFactor = CameraModel.GetUndistortOverscanFactor(DistortedHorizontalFOV, DistortedAspectRatio);
+	UndistortOverscanFactor = CameraModel.GetUndistortOverscanFactor(DistortedHorizontalFOV, DistortedAspectRatio, bPrecise);
 }
 
 
@@ -29,12 +35,153 @@ void ULensDistortionBlueprintLibrary::DrawUVDisplacementToRenderTarget(
 	float UndistortOverscanFactor,
 	class UTextureRenderTarget2D* OutputRenderTarget,
 	float OutputMultiply,
-	float OutputAdd)
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection)
 {
 	CameraModel.DrawUVDisplacementToRenderTarget(
 		WorldContextObject->GetWorld(),
 		DistortedHorizontalFOV, DistortedAspectRatio,
 		UndistortOverscanFactor, OutputRenderTarget,
-		OutputMultiply, OutputAdd);
+		OutputMultiply, OutputAdd, SingleDirection);
+}
+
+
+// static
+void ULensDistortionBlueprintLibrary::DrawAnimatedUVDisplacementToRenderTarget(
+	const UObject* WorldContextObject,
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	class UTextureRenderTarget2D* OutputRenderTarget,
+	float OutputMultiply,
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection)
+{
+	CameraModel.DrawAnimatedUVDisplacementToRenderTarget(
+		WorldContextObject->GetWorld(),
+		DistortedHorizontalFOV, DistortedAspectRatio,
+		UndistortOverscanFactor, OutputRenderTarget,
+		OutputMultiply, OutputAdd, SingleDirection);
+}
+
+
+// static
+void ULensDistortionBlueprintLibrary::ApplyLensDistortionToRenderTarget(
+	const UObject* WorldContextObject,
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	class UTexture* InputTexture,
+	class UTextureRenderTarget2D* OutputRenderTarget,
+	ELensDistortionApplyMode Mode,
+	bool bUseDisplacementMap)
+{
+	CameraModel.ApplyToRenderTarget(
+		WorldContextObject->GetWorld(),
+		DistortedHorizontalFOV, DistortedAspectRatio,
+		UndistortOverscanFactor, InputTexture, OutputRenderTarget,
+		Mode, bUseDisplacementMap);
+}
+
+
+// static
+void ULensDistortionBlueprintLibrary::SetLensDistortionPostProcess(
+	const FFooCameraModel& CameraModel,
+	float UndistortOverscanFactor,
+	ELensDistortionApplyMode Mode,
+	bool bUseDisplacementMap)
+{
+	FLensDistortionPostProcessSettings Settings;
+	Settings.CameraModel = CameraModel;
+	Settings.UndistortOverscanFactor = FMath::Max(UndistortOverscanFactor, 1.0f);
+	Settings.Mode = Mode;
+	Settings.bUseDisplacementMap = bUseDisplacementMap;
+	FLensDistortionSceneViewExtension::Enable(Settings);
+}
+
+
+// static
+void ULensDistortionBlueprintLibrary::ClearLensDistortionPostProcess()
+{
+	FLensDistortionSceneViewExtension::Disable();
+}
+
+
+// static
+void ULensDistortionBlueprintLibrary::DrawUVDisplacementsToRenderTargetArray(
+	const UObject* WorldContextObject,
+	const TArray<FLensDistortionCamera>& Cameras,
+	class UTextureRenderTarget2DArray* OutputRenderTarget,
+	float OutputMultiply,
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection)
+{
+	FFooCameraModel::DrawUVDisplacementsToRenderTargetArray(
+		WorldContextObject->GetWorld(),
+		Cameras, OutputRenderTarget,
+		OutputMultiply, OutputAdd, SingleDirection);
+}
+
+
+// static
+void ULensDistortionBlueprintLibrary::GetNormalizedUVDisplacementRange(
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	float& OutputMultiply,
+	float& OutputAdd)
+{
+	CameraModel.GetNormalizedUVDisplacementMultiplyAndAdd(DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputMultiply, OutputAdd);
+}
+
+
+// static
+bool ULensDistortionBlueprintLibrary::CompareUVDisplacementRenderTargetToCPU(
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	class UTextureRenderTarget2D* RenderTarget,
+	float& MaxError,
+	float OutputMultiply,
+	float OutputAdd,
+	float Tolerance,
+	ELensDistortionApplyMode SingleDirection)
+{
+	MaxError = 0.f;
+
+	const EPixelFormat Format = RenderTarget ? RenderTarget->GetFormat() : PF_Unknown;
+	const ELensDistortionDisplacementEncoding Encoding = GetUVDisplacementEncoding(Format, SingleDirection);
+	if (Encoding == ELensDistortionDisplacementEncoding::PackedHalf)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ULensDistortionBlueprintLibrary::CompareUVDisplacementRenderTargetToCPU, %s: packed displacement maps are not supported"),
+			*RenderTarget->GetName());
+		return false;
+	}
+
+	// The displacement map may still be queued in the frame graph.
+	FShaderTestFrameGraph::EnqueueFlush();
+
+	FTextureRenderTargetResource* RenderTargetResource = RenderTarget ? RenderTarget->GameThread_GetRenderTargetResource() : nullptr;
+	TArray<FLinearColor> Pixels;
+	if (!RenderTargetResource || !RenderTargetResource->ReadLinearColorPixels(Pixels))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ULensDistortionBlueprintLibrary::CompareUVDisplacementRenderTargetToCPU, failed to read the render target"));
+		return false;
+	}
+
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::CompileForFormat(
+		CameraModel, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, Format, OutputMultiply, OutputAdd, SingleDirection);
+	const FIntPoint Resolution(RenderTarget->SizeX, RenderTarget->SizeY);
+
+	const FLensDistortionDisplacementComparison Comparison = CompareUVDisplacementToCPU(CompiledCameraModel, Resolution, Pixels, Tolerance, Encoding);
+	UE_LOG(LogTemp, Log, TEXT("ULensDistortionBlueprintLibrary::CompareUVDisplacementRenderTargetToCPU, %s: %d/%d pixels above %f, max error %f, mean error %f"),
+		*RenderTarget->GetName(), Comparison.NumPixelsAboveTolerance, Comparison.NumComparedPixels, Tolerance, Comparison.MaxError, Comparison.MeanError);
+
+	MaxError = Comparison.MaxError;
+	return Comparison.IsWithinTolerance();
 }
 PRAGMA_ENABLE_DEPRECATION_WARNINGS
@@ -5,7 +5,7 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
-#include "LensDistortionAPI.h"
+#include "GlobalShaderExample/LensDistortionAPI.h"
 #include "LensDistortionBlueprintLibrary.generated.h"
 
 
@@ -17,23 +17,30 @@ class ULensDistortionBlueprintLibrary : public UBlueprintFunctionLibrary
 
 
 	PRAGMA_DISABLE_DEPRECATION_WARNINGS
-	/** Returns the overscan factor required for the undistort rendering to avoid unrendered distorted pixels. */
+	/** Returns the overscan factor required for the undistort rendering to avoid unrendered distorted pixels.
+	 * @param bPrecise Tightest overscan bounded from the whole distorted viewport border, memoized per camera model, FOV and aspect ratio.
+	 */
 	UFUNCTION(BlueprintPure,  Category = "Foo | Lens Distortion", meta = (DeprecatedFunction, DeprecationMessage = "The LensDistortion plugin is deprecated. Please update your project to use the features of the CameraCalibration plugin."))
 	static void GetUndistortOverscanFactor(
 		const FFooCameraModel& CameraModel,
 		float DistortedHorizontalFOV,
 		float DistortedAspectRatio,
-		float& UndistortOverscanFactor);
+		float& UndistortOverscanFactor,
+		bool bPrecise = false);
 		
 	/** Draws UV displacement map within the output render target.
 	 * - Red & green channels hold the distortion displacement;
 	 * - Blue & alpha channels hold the undistortion displacement.
+	 * RG16F and RG32F render targets hold the SingleDirection displacement in red & green, RG32_UINT ones hold both directions
+	 * packed as halves.
 	 * @param DistortedHorizontalFOV The desired horizontal FOV in the distorted render.
 	 * @param DistortedAspectRatio The desired aspect ratio of the distorted render.
 	 * @param UndistortOverscanFactor The factor of the overscan for the undistorted render.
 	 * @param OutputRenderTarget The render target to draw to. Don't necessarily need to have same resolution or aspect ratio as distorted render.
-	 * @param OutputMultiply The multiplication factor applied on the displacement.
+	 * @param OutputMultiply The multiplication factor applied on the displacement. On the 8 bit normalized formats, <= 0 fits
+	 *        the displacements in [0, 1] instead, see GetNormalizedUVDisplacementRange.
 	 * @param OutputAdd Value added to the multiplied displacement before storing into the output render target.
+	 * @param SingleDirection Displacement held by the two channel render targets.
 	 */
 	UFUNCTION(BlueprintCallable,  Category = "Foo | Lens Distortion", meta = (WorldContext = "WorldContextObject"))
 	static void DrawUVDisplacementToRenderTarget(
@@ -44,7 +51,110 @@ class ULensDistortionBlueprintLibrary : public UBlueprintFunctionLibrary
 		float UndistortOverscanFactor,
 		class UTextureRenderTarget2D* OutputRenderTarget,
 		float OutputMultiply = 0.5,
-		float OutputAdd = 0.5
+		float OutputAdd = 0.5,
+		ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort
+		);
+
+	/** Draws the UV displacement map of a camera model animated every frame, such as by Sequencer, within the output render target.
+	 * The next map is generated on async compute while the render target keeps the previous one, so it lags one draw behind
+	 * while the camera model moves. Changes below r.ShaderTest.LensDistortion.AnimatedEpsilon are skipped.
+	 * The first map of a render target is generated on the graphics pipe and shown by that same draw.
+	 * Same parameters as DrawUVDisplacementToRenderTarget.
+	 */
+	UFUNCTION(BlueprintCallable,  Category = "Foo | Lens Distortion", meta = (WorldContext = "WorldContextObject"))
+	static void DrawAnimatedUVDisplacementToRenderTarget(
+		const UObject* WorldContextObject,
+		const FFooCameraModel& CameraModel,
+		float DistortedHorizontalFOV,
+		float DistortedAspectRatio,
+		float UndistortOverscanFactor,
+		class UTextureRenderTarget2D* OutputRenderTarget,
+		float OutputMultiply = 0.5,
+		float OutputAdd = 0.5,
+		ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort
+		);
+
+	/** Draws the UV displacement maps of several cameras within the slices of the output render target array in a single
+	 * compute dispatch, slice i for Cameras[i]. Same channels and parameters as DrawUVDisplacementToRenderTarget.
+	 */
+	UFUNCTION(BlueprintCallable,  Category = "Foo | Lens Distortion", meta = (WorldContext = "WorldContextObject"))
+	static void DrawUVDisplacementsToRenderTargetArray(
+		const UObject* WorldContextObject,
+		const TArray<FLensDistortionCamera>& Cameras,
+		class UTextureRenderTarget2DArray* OutputRenderTarget,
+		float OutputMultiply = 0.5,
+		float OutputAdd = 0.5,
+		ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort
+		);
+
+	/** Returns the output multiply and add fitting the displacements of the lens in [0, 1], used by the 8 bit normalized
+	 * render targets drawn with an OutputMultiply <= 0. Decode with (Color - OutputAdd) / OutputMultiply.
+	 */
+	UFUNCTION(BlueprintPure,  Category = "Foo | Lens Distortion")
+	static void GetNormalizedUVDisplacementRange(
+		const FFooCameraModel& CameraModel,
+		float DistortedHorizontalFOV,
+		float DistortedAspectRatio,
+		float UndistortOverscanFactor,
+		float& OutputMultiply,
+		float& OutputAdd);
+
+	/** Warps the input texture into the output render target with the lens distortion in a single pass.
+	 * @param DistortedHorizontalFOV The desired horizontal FOV in the distorted render.
+	 * @param DistortedAspectRatio The desired aspect ratio of the distorted render.
+	 * @param UndistortOverscanFactor The factor of the overscan for the undistorted render.
+	 * @param InputTexture Undistorted render to distort, or distorted image to undistort.
+	 * @param OutputRenderTarget The render target to draw to.
+	 * @param bUseDisplacementMap Reads the warp from the cached displacement map of the output resolution instead of evaluating the lens per pixel.
+	 */
+	UFUNCTION(BlueprintCallable,  Category = "Foo | Lens Distortion", meta = (WorldContext = "WorldContextObject"))
+	static void ApplyLensDistortionToRenderTarget(
+		const UObject* WorldContextObject,
+		const FFooCameraModel& CameraModel,
+		float DistortedHorizontalFOV,
+		float DistortedAspectRatio,
+		float UndistortOverscanFactor,
+		class UTexture* InputTexture,
+		class UTextureRenderTarget2D* OutputRenderTarget,
+		ELensDistortionApplyMode Mode = ELensDistortionApplyMode::Distort,
+		bool bUseDisplacementMap = false
+		);
+
+	/** Applies the lens distortion to the scene color of every perspective view after the tonemapper, until cleared.
+	 * @param UndistortOverscanFactor The factor of the overscan for the undistorted render, the views are rendered overscanned to be distorted.
+	 * @param bUseDisplacementMap Reads the warp from the cached displacement map of the view size instead of evaluating the lens per pixel.
+	 */
+	UFUNCTION(BlueprintCallable,  Category = "Foo | Lens Distortion")
+	static void SetLensDistortionPostProcess(
+		const FFooCameraModel& CameraModel,
+		float UndistortOverscanFactor = 1.0,
+		ELensDistortionApplyMode Mode = ELensDistortionApplyMode::Distort,
+		bool bUseDisplacementMap = false
+		);
+
+	/** Stops applying the lens distortion of SetLensDistortionPostProcess to the views. */
+	UFUNCTION(BlueprintCallable,  Category = "Foo | Lens Distortion")
+	static void ClearLensDistortionPostProcess();
+
+	/** Compares a displacement map drawn by DrawUVDisplacementToRenderTarget against the CPU generated one.
+	 * Reads the render target back, stalling the game thread: meant for validation only. The packed RG32_UINT format
+	 * is not supported.
+	 * @param MaxError Largest channel difference found on the pixels covered by the GPU pass.
+	 * @param Tolerance Largest channel difference allowed, in the output render target's units.
+	 * @return Whether every compared pixel is within the tolerance.
+	 */
+	UFUNCTION(BlueprintCallable,  Category = "Foo | Lens Distortion")
+	static bool CompareUVDisplacementRenderTargetToCPU(
+		const FFooCameraModel& CameraModel,
+		float DistortedHorizontalFOV,
+		float DistortedAspectRatio,
+		float UndistortOverscanFactor,
+		class UTextureRenderTarget2D* RenderTarget,
+		float& MaxError,
+		float OutputMultiply = 0.5,
+		float OutputAdd = 0.5,
+		float Tolerance = 0.002,
+		ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort
 		);
 
 	/* Returns true if A is equal to B (A == B) */
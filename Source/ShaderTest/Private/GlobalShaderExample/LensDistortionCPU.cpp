@@ -0,0 +1,500 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LensDistortionCPU.h"
+#include "LensDistortionSIMD.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Math/Float16Color.h"
+
+
+/** Samples per distorted viewport edge of the precise overscan factor. */
+static constexpr int32 kOverscanSamplesPerEdge = 256;
+
+/** Ternary search iterations refining each edge's extremum between its neighbouring samples. */
+static constexpr int32 kOverscanRefineIterations = 24;
+
+/** Margin of the precise overscan factor, only covering the float precision of the undistortion shaders. */
+static constexpr float kPreciseOverscanMargin = 1.0005f;
+
+/** Memoized precise overscan factors, emptied once full. */
+static constexpr int32 kOverscanCacheMaxEntries = 256;
+
+
+/** Positions per task of the batch APIs, batches spanning a single task run on the calling thread. */
+static constexpr int32 kLensDistortionPositionsPerTask = 1024;
+
+
+/** Runs Kernel(X, Y, OutX, OutY) -> ConvergedMask over the positions 4 at a time, in the standard view space. */
+template<typename TKernel>
+static int32 ForEachNormalizedViewPositions(TArrayView<const FVector2D> InPositions, TArrayView<FVector2D> OutPositions, TKernel Kernel)
+{
+	check(InPositions.Num() == OutPositions.Num());
+
+	FThreadSafeCounter NumNotConverged;
+	const int32 NumTasks = FMath::DivideAndRoundUp(InPositions.Num(), kLensDistortionPositionsPerTask);
+
+	ParallelFor(NumTasks, [&](int32 TaskIndex)
+	{
+		const int32 Begin = TaskIndex * kLensDistortionPositionsPerTask;
+		const int32 End = FMath::Min(Begin + kLensDistortionPositionsPerTask, InPositions.Num());
+
+		for (int32 Index = Begin; Index < End; Index += 4)
+		{
+			const int32 NumLanes = FMath::Min(4, End - Index);
+
+			// Engine view space -> standard view space, unused lanes are evaluated at the origin.
+			MS_ALIGN(16) float X[4] GCC_ALIGN(16) = { 0.f, 0.f, 0.f, 0.f };
+			MS_ALIGN(16) float Y[4] GCC_ALIGN(16) = { 0.f, 0.f, 0.f, 0.f };
+			for (int32 Lane = 0; Lane < NumLanes; Lane++)
+			{
+				X[Lane] = float(InPositions[Index + Lane].X);
+				Y[Lane] = -float(InPositions[Index + Lane].Y);
+			}
+
+			VectorRegister4Float OutX, OutY;
+			const int32 ConvergedMask = Kernel(VectorLoadAligned(X), VectorLoadAligned(Y), OutX, OutY);
+			VectorStoreAligned(OutX, X);
+			VectorStoreAligned(OutY, Y);
+
+			for (int32 Lane = 0; Lane < NumLanes; Lane++)
+			{
+				OutPositions[Index + Lane] = FVector2D(X[Lane], -Y[Lane]);
+			}
+
+			const int32 NotConvergedMask = ~ConvergedMask & ((1 << NumLanes) - 1);
+			if (NotConvergedMask)
+			{
+				NumNotConverged.Add(FMath::CountBits(NotConvergedMask));
+			}
+		}
+	}, NumTasks < 2);
+
+	return NumNotConverged.GetValue();
+}
+
+
+template<typename TPixel>
+static void DrawUVDisplacementToBuffer_Internal(
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint OutputResolution,
+	TArray<TPixel>& OutDisplacementMap,
+	TArray<uint8>* OutCoverage)
+{
+	check(OutputResolution.X > 0 && OutputResolution.Y > 0);
+
+	OutDisplacementMap.SetNumUninitialized(OutputResolution.X * OutputResolution.Y);
+	if (OutCoverage)
+	{
+		OutCoverage->SetNumUninitialized(OutputResolution.X * OutputResolution.Y);
+	}
+
+	const FLensDistortionVectorModel Model(CompiledCameraModel.OriginalCameraModel);
+	const FVector2f PixelUVSize(1.f / float(OutputResolution.X), 1.f / float(OutputResolution.Y));
+	const FVector4f DistortedCameraMatrix(CompiledCameraModel.DistortedCameraMatrix);
+	const FVector4f UndistortedCameraMatrix(CompiledCameraModel.UndistortedCameraMatrix);
+	const float OutputMultiply = CompiledCameraModel.OutputMultiplyAndAdd.X;
+	const float OutputAdd = CompiledCameraModel.OutputMultiplyAndAdd.Y;
+
+	// The grid of the GPU pass covers the distorted viewport UVs [0, 1] shifted by half a pixel, minus a pixel of
+	// margin for the rasterization rules on its border.
+	const FVector2f MinGridUV = PixelUVSize * 0.5f;
+	const FVector2f MaxGridUV = FVector2f(1.f, 1.f) - PixelUVSize * 1.5f;
+
+	ParallelFor(OutputResolution.Y, [&](int32 Y)
+	{
+		const VectorRegister4Float LaneOffsets = MakeVectorRegisterFloat(0.f, 1.f, 2.f, 3.f);
+		const VectorRegister4Float PixelUSize = VectorSetFloat1(PixelUVSize.X);
+
+		// Pixel center minus the half pixel shift of MainPS.
+		const VectorRegister4Float ViewportV = VectorSetFloat1(float(Y) * PixelUVSize.Y);
+
+		TPixel* RESTRICT Row = OutDisplacementMap.GetData() + Y * OutputResolution.X;
+		uint8* RESTRICT CoverageRow = OutCoverage ? OutCoverage->GetData() + Y * OutputResolution.X : nullptr;
+
+		for (int32 X = 0; X < OutputResolution.X; X += 4)
+		{
+			const VectorRegister4Float ViewportU = VectorMultiply(VectorAdd(VectorSetFloat1(float(X)), LaneOffsets), PixelUSize);
+
+			// Distorted viewport UV -> undistorted viewport UV, see UndistortViewportUV().
+			VectorRegister4Float UndistortedX, UndistortedY;
+			VectorUndistortNormalizedViewPosition(Model,
+				VectorMultiply(VectorSubtract(ViewportU, VectorSetFloat1(DistortedCameraMatrix.Z)), VectorSetFloat1(1.f / DistortedCameraMatrix.X)),
+				VectorMultiply(VectorSubtract(ViewportV, VectorSetFloat1(DistortedCameraMatrix.W)), VectorSetFloat1(1.f / DistortedCameraMatrix.Y)),
+				UndistortedX, UndistortedY);
+
+			const VectorRegister4Float DistortToUndistortU = VectorSubtract(
+				VectorMultiplyAdd(VectorSetFloat1(UndistortedCameraMatrix.X), UndistortedX, VectorSetFloat1(UndistortedCameraMatrix.Z)), ViewportU);
+			const VectorRegister4Float DistortToUndistortV = VectorSubtract(
+				VectorMultiplyAdd(VectorSetFloat1(UndistortedCameraMatrix.Y), UndistortedY, VectorSetFloat1(UndistortedCameraMatrix.W)), ViewportV);
+
+			// Undistorted viewport UV -> distorted viewport UV, what the GPU grid interpolates.
+			VectorRegister4Float DistortedX, DistortedY;
+			const int32 ConvergedMask = VectorDistortNormalizedViewPosition(Model,
+				VectorMultiply(VectorSubtract(ViewportU, VectorSetFloat1(UndistortedCameraMatrix.Z)), VectorSetFloat1(1.f / UndistortedCameraMatrix.X)),
+				VectorMultiply(VectorSubtract(ViewportV, VectorSetFloat1(UndistortedCameraMatrix.W)), VectorSetFloat1(1.f / UndistortedCameraMatrix.Y)),
+				DistortedX, DistortedY);
+
+			const VectorRegister4Float GridU = VectorMultiplyAdd(VectorSetFloat1(DistortedCameraMatrix.X), DistortedX, VectorSetFloat1(DistortedCameraMatrix.Z));
+			const VectorRegister4Float GridV = VectorMultiplyAdd(VectorSetFloat1(DistortedCameraMatrix.Y), DistortedY, VectorSetFloat1(DistortedCameraMatrix.W));
+
+			MS_ALIGN(16) float Channels[4][4] GCC_ALIGN(16);
+			VectorStoreAligned(VectorMultiplyAdd(DistortToUndistortU, VectorSetFloat1(OutputMultiply), VectorSetFloat1(OutputAdd)), Channels[0]);
+			VectorStoreAligned(VectorMultiplyAdd(DistortToUndistortV, VectorSetFloat1(OutputMultiply), VectorSetFloat1(OutputAdd)), Channels[1]);
+			VectorStoreAligned(VectorMultiplyAdd(VectorSubtract(GridU, ViewportU), VectorSetFloat1(OutputMultiply), VectorSetFloat1(OutputAdd)), Channels[2]);
+			VectorStoreAligned(VectorMultiplyAdd(VectorSubtract(GridV, ViewportV), VectorSetFloat1(OutputMultiply), VectorSetFloat1(OutputAdd)), Channels[3]);
+
+			const int32 NumLanes = FMath::Min(4, OutputResolution.X - X);
+			for (int32 Lane = 0; Lane < NumLanes; Lane++)
+			{
+				Row[X + Lane] = TPixel(FLinearColor(Channels[0][Lane], Channels[1][Lane], Channels[2][Lane], Channels[3][Lane]));
+			}
+
+			if (CoverageRow)
+			{
+				const int32 InGridMask = ConvergedMask & VectorMaskBits(VectorBitwiseAnd(
+					VectorBitwiseAnd(VectorCompareGE(GridU, VectorSetFloat1(MinGridUV.X)), VectorCompareLE(GridU, VectorSetFloat1(MaxGridUV.X))),
+					VectorBitwiseAnd(VectorCompareGE(GridV, VectorSetFloat1(MinGridUV.Y)), VectorCompareLE(GridV, VectorSetFloat1(MaxGridUV.Y)))));
+
+				for (int32 Lane = 0; Lane < NumLanes; Lane++)
+				{
+					CoverageRow[X + Lane] = (InGridMask >> Lane) & 0x1;
+				}
+			}
+		}
+	});
+}
+
+
+void DrawUVDisplacementToBuffer_CPU(
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint OutputResolution,
+	TArray<FLinearColor>& OutDisplacementMap,
+	TArray<uint8>* OutCoverage)
+{
+	DrawUVDisplacementToBuffer_Internal(CompiledCameraModel, OutputResolution, OutDisplacementMap, OutCoverage);
+}
+
+
+void DrawUVDisplacementToBuffer_CPU(
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint OutputResolution,
+	TArray<FFloat16Color>& OutDisplacementMap,
+	TArray<uint8>* OutCoverage)
+{
+	DrawUVDisplacementToBuffer_Internal(CompiledCameraModel, OutputResolution, OutDisplacementMap, OutCoverage);
+}
+
+
+FLensDistortionDisplacementComparison CompareUVDisplacementToCPU(
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint Resolution,
+	TConstArrayView<FLinearColor> Pixels,
+	float Tolerance,
+	ELensDistortionDisplacementEncoding Encoding)
+{
+	check(Pixels.Num() == Resolution.X * Resolution.Y);
+
+	TArray<FLinearColor> Reference;
+	TArray<uint8> Coverage;
+	DrawUVDisplacementToBuffer_CPU(CompiledCameraModel, Resolution, Reference, &Coverage);
+
+	FLensDistortionDisplacementComparison Comparison;
+	double ErrorSum = 0.0;
+	for (int32 PixelIndex = 0; PixelIndex < Pixels.Num(); PixelIndex++)
+	{
+		if (!Coverage[PixelIndex])
+		{
+			continue;
+		}
+
+		const FLinearColor& Pixel = Pixels[PixelIndex];
+		const FLinearColor& ReferencePixel = Reference[PixelIndex];
+
+		float Error;
+		if (Encoding == ELensDistortionDisplacementEncoding::DistortRG)
+		{
+			Error = FMath::Max(FMath::Abs(Pixel.R - ReferencePixel.R), FMath::Abs(Pixel.G - ReferencePixel.G));
+		}
+		else if (Encoding == ELensDistortionDisplacementEncoding::UndistortRG)
+		{
+			Error = FMath::Max(FMath::Abs(Pixel.R - ReferencePixel.B), FMath::Abs(Pixel.G - ReferencePixel.A));
+		}
+		else
+		{
+			const FLinearColor Difference = Pixel - ReferencePixel;
+			Error = FMath::Max(
+				FMath::Max(FMath::Abs(Difference.R), FMath::Abs(Difference.G)),
+				FMath::Max(FMath::Abs(Difference.B), FMath::Abs(Difference.A)));
+		}
+
+		Comparison.MaxError = FMath::Max(Comparison.MaxError, Error);
+		Comparison.NumComparedPixels++;
+		Comparison.NumPixelsAboveTolerance += Error > Tolerance ? 1 : 0;
+		ErrorSum += Error;
+	}
+
+	Comparison.MeanError = Comparison.NumComparedPixels > 0 ? float(ErrorSum / Comparison.NumComparedPixels) : 0.f;
+	return Comparison;
+}
+
+
+float GetMaxUVDisplacement_CPU(const FCompiledCameraModel& CompiledCameraModel)
+{
+	// Coarse enough to be drawn on the game thread, the margin of GetNormalizedUVDisplacementMultiplyAndAdd() covers the
+	// extremums between the probes.
+	const FIntPoint ProbeResolution(64, 64);
+
+	FCompiledCameraModel UnscaledCameraModel = CompiledCameraModel;
+	UnscaledCameraModel.OutputMultiplyAndAdd = FVector2D(1.0f, 0.0f);
+
+	TArray<FLinearColor> DisplacementMap;
+	TArray<uint8> Coverage;
+	DrawUVDisplacementToBuffer_CPU(UnscaledCameraModel, ProbeResolution, DisplacementMap, &Coverage);
+
+	float MaxDisplacement = 0.0f;
+	for (int32 PixelIndex = 0; PixelIndex < DisplacementMap.Num(); PixelIndex++)
+	{
+		const FLinearColor& Displacement = DisplacementMap[PixelIndex];
+		MaxDisplacement = FMath::Max3(MaxDisplacement, FMath::Abs(Displacement.R), FMath::Abs(Displacement.G));
+
+		// Out of the grid, the undistortion displacement may be the last iterate of a diverging Newton solve.
+		if (Coverage[PixelIndex])
+		{
+			MaxDisplacement = FMath::Max3(MaxDisplacement, FMath::Abs(Displacement.B), FMath::Abs(Displacement.A));
+		}
+	}
+	return MaxDisplacement;
+}
+
+
+void FFooCameraModel::GetNormalizedUVDisplacementMultiplyAndAdd(
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	float& OutputMultiply,
+	float& OutputAdd) const
+{
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::Compile(
+		*this, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, 1.0f, 0.0f);
+
+	// Padded for the extremums between the CPU probes.
+	const float MaxDisplacement = GetMaxUVDisplacement_CPU(CompiledCameraModel) * 1.05f;
+
+	OutputMultiply = MaxDisplacement > 0.0f ? 0.5f / MaxDisplacement : 1.0f;
+	OutputAdd = 0.5f;
+}
+
+
+void FFooCameraModel::DrawUVDisplacementToBuffer(
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	FIntPoint OutputResolution,
+	TArray<FLinearColor>& OutDisplacementMap,
+	float OutputMultiply,
+	float OutputAdd) const
+{
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::Compile(
+		*this, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputMultiply, OutputAdd);
+	DrawUVDisplacementToBuffer_CPU(CompiledCameraModel, OutputResolution, OutDisplacementMap);
+}
+
+
+void FFooCameraModel::DrawUVDisplacementToBuffer(
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	FIntPoint OutputResolution,
+	TArray<FFloat16Color>& OutDisplacementMap,
+	float OutputMultiply,
+	float OutputAdd) const
+{
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::Compile(
+		*this, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputMultiply, OutputAdd);
+	DrawUVDisplacementToBuffer_CPU(CompiledCameraModel, OutputResolution, OutDisplacementMap);
+}
+
+
+FVector2D FFooCameraModel::DistortNormalizedViewPosition(FVector2D EngineV) const
+{
+	FVector2D V;
+	DistortNormalizedViewPositions(MakeArrayView(&EngineV, 1), MakeArrayView(&V, 1));
+	return V;
+}
+
+
+void FFooCameraModel::UndistortNormalizedViewPositions(TArrayView<const FVector2D> InPositions, TArrayView<FVector2D> OutPositions) const
+{
+	const FLensDistortionVectorModel Model(*this);
+	ForEachNormalizedViewPositions(InPositions, OutPositions,
+		[&Model](const VectorRegister4Float& X, const VectorRegister4Float& Y, VectorRegister4Float& OutX, VectorRegister4Float& OutY)
+		{
+			VectorUndistortNormalizedViewPosition(Model, X, Y, OutX, OutY);
+			return 0xF;
+		});
+}
+
+
+int32 FFooCameraModel::DistortNormalizedViewPositions(TArrayView<const FVector2D> InPositions, TArrayView<FVector2D> OutPositions, int32 NumIterations) const
+{
+	const FLensDistortionVectorModel Model(*this);
+	return ForEachNormalizedViewPositions(InPositions, OutPositions,
+		[&Model, NumIterations](const VectorRegister4Float& X, const VectorRegister4Float& Y, VectorRegister4Float& OutX, VectorRegister4Float& OutY)
+		{
+			return VectorDistortNormalizedViewPosition(Model, X, Y, OutX, OutY, NumIterations);
+		});
+}
+
+
+/** Camera model, FOV and aspect ratio of a memoized precise overscan factor. */
+struct FOverscanFactorKey
+{
+	float Values[11];
+
+	FOverscanFactorKey(const FFooCameraModel& CameraModel, float DistortedHorizontalFOV, float DistortedAspectRatio)
+	{
+		const float KeyValues[UE_ARRAY_COUNT(Values)] = {
+			CameraModel.K1, CameraModel.K2, CameraModel.K3, CameraModel.P1, CameraModel.P2,
+			float(CameraModel.F.X), float(CameraModel.F.Y), float(CameraModel.C.X), float(CameraModel.C.Y),
+			DistortedHorizontalFOV, DistortedAspectRatio,
+		};
+		FMemory::Memcpy(Values, KeyValues, sizeof(Values));
+	}
+
+	bool operator==(const FOverscanFactorKey& Other) const
+	{
+		return FMemory::Memcmp(Values, Other.Values, sizeof(Values)) == 0;
+	}
+
+	friend uint32 GetTypeHash(const FOverscanFactorKey& Key)
+	{
+		return FCrc::MemCrc32(Key.Values, sizeof(Key.Values));
+	}
+};
+
+static FCriticalSection GOverscanFactorCacheLock;
+static TMap<FOverscanFactorKey, float> GOverscanFactorCache;
+
+
+static float ComputePreciseUndistortOverscanFactor(
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio)
+{
+	const double TanHalfDistortedHorizontalFOV = FMath::Tan(DistortedHorizontalFOV * 0.5f);
+	const FVector2D AspectRatioAwareF = CameraModel.F * FVector2D(1, -DistortedAspectRatio);
+
+	/** Edge of the distorted viewport and the component of its undistorted view positions bounding the inner viewport rect. */
+	struct FEdge
+	{
+		FVector2D Origin;
+		FVector2D Direction;
+		int32 Axis;
+		double Sign;
+	};
+
+	// Signs are set so that the bound is the maximum of Sign * position.
+	const FEdge Edges[4] = {
+		{ FVector2D(0.0, 0.0), FVector2D(1.0, 0.0), 1, -1.0 }, // Top: MaxInnerViewportRect.Y
+		{ FVector2D(0.0, 1.0), FVector2D(1.0, 0.0), 1,  1.0 }, // Bottom: MinInnerViewportRect.Y
+		{ FVector2D(0.0, 0.0), FVector2D(0.0, 1.0), 0,  1.0 }, // Left: MinInnerViewportRect.X
+		{ FVector2D(1.0, 0.0), FVector2D(0.0, 1.0), 0, -1.0 }, // Right: MaxInnerViewportRect.X
+	};
+
+	const double SampleStep = 1.0 / double(kOverscanSamplesPerEdge - 1);
+
+	TArray<FVector2D> Positions;
+	Positions.SetNumUninitialized(UE_ARRAY_COUNT(Edges) * kOverscanSamplesPerEdge);
+	for (int32 EdgeIndex = 0; EdgeIndex < UE_ARRAY_COUNT(Edges); EdgeIndex++)
+	{
+		for (int32 SampleIndex = 0; SampleIndex < kOverscanSamplesPerEdge; SampleIndex++)
+		{
+			const FVector2D DistortedViewportUV = Edges[EdgeIndex].Origin + Edges[EdgeIndex].Direction * (SampleIndex * SampleStep);
+			Positions[EdgeIndex * kOverscanSamplesPerEdge + SampleIndex] = (DistortedViewportUV - CameraModel.C) / AspectRatioAwareF;
+		}
+	}
+	CameraModel.UndistortNormalizedViewPositions(Positions, Positions);
+
+	double Bounds[4];
+	for (int32 EdgeIndex = 0; EdgeIndex < UE_ARRAY_COUNT(Edges); EdgeIndex++)
+	{
+		const FEdge& Edge = Edges[EdgeIndex];
+		auto Evaluate = [&](double T)
+		{
+			const FVector2D DistortedViewportUV = Edge.Origin + Edge.Direction * T;
+			return Edge.Sign * CameraModel.UndistortNormalizedViewPosition((DistortedViewportUV - CameraModel.C) / AspectRatioAwareF)[Edge.Axis];
+		};
+
+		int32 BestSampleIndex = 0;
+		for (int32 SampleIndex = 1; SampleIndex < kOverscanSamplesPerEdge; SampleIndex++)
+		{
+			const FVector2D* EdgePositions = &Positions[EdgeIndex * kOverscanSamplesPerEdge];
+			if (Edge.Sign * EdgePositions[SampleIndex][Edge.Axis] > Edge.Sign * EdgePositions[BestSampleIndex][Edge.Axis])
+			{
+				BestSampleIndex = SampleIndex;
+			}
+		}
+
+		// Ternary search of the extremum between the neighbouring samples.
+		double Low = FMath::Max(BestSampleIndex - 1, 0) * SampleStep;
+		double High = FMath::Min(BestSampleIndex + 1, kOverscanSamplesPerEdge - 1) * SampleStep;
+		for (int32 Iteration = 0; Iteration < kOverscanRefineIterations; Iteration++)
+		{
+			const double Third = (High - Low) / 3.0;
+			if (Evaluate(Low + Third) < Evaluate(High - Third))
+			{
+				Low += Third;
+			}
+			else
+			{
+				High -= Third;
+			}
+		}
+
+		Bounds[EdgeIndex] = Edge.Sign * FMath::Max(Evaluate(0.5 * (Low + High)), Evaluate(BestSampleIndex * SampleStep));
+	}
+
+	FVector2D MinInnerViewportRect(Bounds[2], Bounds[1]);
+	FVector2D MaxInnerViewportRect(Bounds[3], Bounds[0]);
+
+	check(MinInnerViewportRect.X < 0.f);
+	check(MinInnerViewportRect.Y < 0.f);
+	check(MaxInnerViewportRect.X > 0.f);
+	check(MaxInnerViewportRect.Y > 0.f);
+
+	// Same as FFooCameraModel::GetUndistortOverscanFactor(), without the 2% scale up.
+	const double TanHalfDistortedVerticalFOV = TanHalfDistortedHorizontalFOV / DistortedAspectRatio;
+	FVector2D ViewportScaleUpFactorPerViewAxis = 0.5 * FVector2D(
+		TanHalfDistortedHorizontalFOV / FMath::Max(-MinInnerViewportRect.X, MaxInnerViewportRect.X),
+		TanHalfDistortedVerticalFOV / FMath::Max(-MinInnerViewportRect.Y, MaxInnerViewportRect.Y));
+
+	return float(FMath::Max(ViewportScaleUpFactorPerViewAxis.X, ViewportScaleUpFactorPerViewAxis.Y)) * kPreciseOverscanMargin;
+}
+
+
+float GetPreciseUndistortOverscanFactor(
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio)
+{
+	const FOverscanFactorKey Key(CameraModel, DistortedHorizontalFOV, DistortedAspectRatio);
+	{
+		FScopeLock Lock(&GOverscanFactorCacheLock);
+		if (const float* OverscanFactor = GOverscanFactorCache.Find(Key))
+		{
+			return *OverscanFactor;
+		}
+	}
+
+	const float OverscanFactor = ComputePreciseUndistortOverscanFactor(CameraModel, DistortedHorizontalFOV, DistortedAspectRatio);
+
+	FScopeLock Lock(&GOverscanFactorCacheLock);
+	if (GOverscanFactorCache.Num() >= kOverscanCacheMaxEntries)
+	{
+		GOverscanFactorCache.Empty();
+	}
+	GOverscanFactorCache.Add(Key, OverscanFactor);
+
+	return OverscanFactor;
+}
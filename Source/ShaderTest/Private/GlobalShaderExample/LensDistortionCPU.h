@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LensDistortionRendering.h"
+
+
+/** Result of the comparison of a displacement map against the CPU generated one. */
+struct FLensDistortionDisplacementComparison
+{
+	/** Largest absolute difference of a channel. */
+	float MaxError = 0.f;
+
+	/** Average of the per pixel largest absolute difference. */
+	float MeanError = 0.f;
+
+	/** Number of pixels covered by the GPU grid pass that got compared. */
+	int32 NumComparedPixels = 0;
+
+	/** Number of compared pixels with a channel difference above the tolerance. */
+	int32 NumPixelsAboveTolerance = 0;
+
+	bool IsWithinTolerance() const
+	{
+		return NumPixelsAboveTolerance == 0;
+	}
+};
+
+
+/** Draws the UV displacement map of a compiled camera model on the CPU, with the same layout as the GPU pass.
+ * @param OutCoverage Optional, set to 1 on the pixels that the GPU grid pass rasterizes, the other pixels of the
+ *        render target are left untouched by DrawUVDisplacementToRenderTarget().
+ */
+void DrawUVDisplacementToBuffer_CPU(
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint OutputResolution,
+	TArray<FLinearColor>& OutDisplacementMap,
+	TArray<uint8>* OutCoverage = nullptr);
+
+void DrawUVDisplacementToBuffer_CPU(
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint OutputResolution,
+	TArray<FFloat16Color>& OutDisplacementMap,
+	TArray<uint8>* OutCoverage = nullptr);
+
+/** Compares a displacement map read back from the GPU pass against the CPU generated one.
+ * @param Pixels Top left originated, row major pixels of the displacement map.
+ * @param Tolerance Largest absolute difference allowed per channel, in the output units (after OutputMultiplyAndAdd).
+ * @param Encoding Encoding of the pixels, the two channel ones are compared in red & green. PackedHalf pixels need
+ *        unpacking into RGBA first.
+ */
+FLensDistortionDisplacementComparison CompareUVDisplacementToCPU(
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint Resolution,
+	TConstArrayView<FLinearColor> Pixels,
+	float Tolerance,
+	ELensDistortionDisplacementEncoding Encoding = ELensDistortionDisplacementEncoding::RGBA);
+
+/** Largest absolute displacement of both directions over the viewport, in viewport UV, from a coarse CPU displacement map.
+ *  The output multiply and add of the compiled camera model are ignored.
+ */
+float GetMaxUVDisplacement_CPU(const FCompiledCameraModel& CompiledCameraModel);
+
+/** Overscan factor of FFooCameraModel::GetUndistortOverscanFactor() bounding the undistorted viewport from the whole
+ *  distorted viewport border: densely sampled with the batch undistort, then refined around each edge's extremum.
+ *  Memoized per camera model, FOV and aspect ratio, thread safe.
+ */
+float GetPreciseUndistortOverscanFactor(
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio);
@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LensDistortionDisplacementCache.h"
+#include "Common/ShaderTestStats.h"
+#include "Common/ShaderTestPassProfiler.h"
+
+#include "RenderTargetPool.h"
+#include "RenderGraphUtils.h"
+
+
+static TAutoConsoleVariable<int32> CVarDisplacementCacheBudgetMB(
+	TEXT("r.ShaderTest.LensDistortion.CacheBudgetMB"),
+	64,
+	TEXT("GPU memory budget in MB of the cached lens distortion displacement maps, least recently used maps are evicted first.\n")
+	TEXT("0 disables the cache, every DrawUVDisplacementToRenderTarget then draws the map."),
+	ECVF_RenderThreadSafe);
+
+TGlobalResource<FLensDistortionDisplacementCache> GLensDistortionDisplacementCache;
+
+
+FLensDistortionDisplacementCache::FKey::FKey(const FCompiledCameraModel& CompiledCameraModel, FIntPoint InResolution, EPixelFormat InFormat, bool bInSRGB)
+	: Resolution(InResolution)
+	, Format(InFormat)
+	, Encoding(GetUVDisplacementEncoding(InFormat, CompiledCameraModel.SingleDirection))
+	, bSRGB(bInSRGB)
+{
+	const FFooCameraModel& CameraModel = CompiledCameraModel.OriginalCameraModel;
+	const float Values[UE_ARRAY_COUNT(Model)] = {
+		CameraModel.K1, CameraModel.K2, CameraModel.K3, CameraModel.P1, CameraModel.P2,
+		float(CompiledCameraModel.DistortedCameraMatrix.X), float(CompiledCameraModel.DistortedCameraMatrix.Y),
+		float(CompiledCameraModel.DistortedCameraMatrix.Z), float(CompiledCameraModel.DistortedCameraMatrix.W),
+		float(CompiledCameraModel.UndistortedCameraMatrix.X), float(CompiledCameraModel.UndistortedCameraMatrix.Y),
+		float(CompiledCameraModel.UndistortedCameraMatrix.Z), float(CompiledCameraModel.UndistortedCameraMatrix.W),
+		float(CompiledCameraModel.OutputMultiplyAndAdd.X), float(CompiledCameraModel.OutputMultiplyAndAdd.Y),
+	};
+	FMemory::Memcpy(Model, Values, sizeof(Model));
+}
+
+
+FLensDistortionDisplacementCache::FKey::FKey(const FCompiledCameraModel& CompiledCameraModel, FRHITexture2D* Texture)
+	: FKey(CompiledCameraModel, Texture->GetSizeXY(), Texture->GetFormat(), EnumHasAnyFlags(Texture->GetFlags(), TexCreate_SRGB))
+{ }
+
+
+ETextureCreateFlags FLensDistortionDisplacementCache::FKey::GetTargetableFlags() const
+{
+	return TexCreate_ShaderResource | (ShouldGenerateUVDisplacementWithCompute(Format, bSRGB) ? TexCreate_UAV : TexCreate_RenderTargetable);
+}
+
+
+void FLensDistortionDisplacementCache::AddDrawUVDisplacementPasses(
+	FRDGBuilder& GraphBuilder,
+	const FCompiledCameraModel& CompiledCameraModel,
+	FRHITexture2D* RenderTargetTexture,
+	TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement)
+{
+	check(IsInRenderingThread());
+
+	const uint64 BudgetInBytes = uint64(FMath::Max(CVarDisplacementCacheBudgetMB.GetValueOnRenderThread(), 0)) * 1024 * 1024;
+	const FKey Key(CompiledCameraModel, RenderTargetTexture);
+
+	FRDGTextureRef RenderTarget = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("LensDistortionDisplacement")));
+	GraphBuilder.SetTextureAccessFinal(RenderTarget, ERHIAccess::SRVMask);
+
+	if (Key.GetSizeInBytes() > BudgetInBytes)
+	{
+		EvictToBudget(BudgetInBytes);
+		GenerateDisplacement(RenderTarget);
+		return;
+	}
+
+	const FEntry& Entry = FindOrAddEntry(GraphBuilder, Key, BudgetInBytes, GenerateDisplacement);
+
+	AddCopyTexturePass(GraphBuilder, GraphBuilder.RegisterExternalTexture(Entry.DisplacementMap), RenderTarget);
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+}
+
+
+FRDGTextureRef FLensDistortionDisplacementCache::AddGetUVDisplacementPasses(
+	FRDGBuilder& GraphBuilder,
+	const FCompiledCameraModel& CompiledCameraModel,
+	FIntPoint Resolution,
+	EPixelFormat Format,
+	TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement)
+{
+	check(IsInRenderingThread());
+
+	const uint64 BudgetInBytes = uint64(FMath::Max(CVarDisplacementCacheBudgetMB.GetValueOnRenderThread(), 0)) * 1024 * 1024;
+	// The map is sampled by the passes of the graph, which read the displacements as written.
+	const FKey Key(CompiledCameraModel, Resolution, Format, false);
+
+	if (Key.GetSizeInBytes() > BudgetInBytes)
+	{
+		EvictToBudget(BudgetInBytes);
+
+		FRDGTextureRef DisplacementMap = GraphBuilder.CreateTexture(
+			FRDGTextureDesc::Create2D(Resolution, Format, FClearValueBinding::None, Key.GetTargetableFlags()),
+			TEXT("LensDistortionDisplacement"));
+		GenerateDisplacement(DisplacementMap);
+		return DisplacementMap;
+	}
+
+	const FEntry& Entry = FindOrAddEntry(GraphBuilder, Key, BudgetInBytes, GenerateDisplacement);
+	return GraphBuilder.RegisterExternalTexture(Entry.DisplacementMap);
+}
+
+
+FLensDistortionDisplacementCache::FEntry& FLensDistortionDisplacementCache::FindOrAddEntry(
+	FRDGBuilder& GraphBuilder,
+	const FKey& Key,
+	uint64 BudgetInBytes,
+	TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement)
+{
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry)
+	{
+		INC_DWORD_STAT(STAT_ShaderTest_DisplacementCacheHits);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_ShaderTest_DisplacementCacheMisses);
+
+		const uint64 SizeInBytes = Key.GetSizeInBytes();
+		EvictToBudget(BudgetInBytes - SizeInBytes);
+
+		FPooledRenderTargetDesc Desc(FPooledRenderTargetDesc::Create2DDesc(
+			Key.Resolution, Key.Format, FClearValueBinding::None, Key.bSRGB ? TexCreate_SRGB : TexCreate_None, Key.GetTargetableFlags(), false));
+		TRefCountPtr<IPooledRenderTarget> DisplacementMap;
+		GRenderTargetPool.FindFreeElement(GraphBuilder.RHICmdList, Desc, DisplacementMap, TEXT("LensDistortionDisplacementCache"));
+
+		GenerateDisplacement(GraphBuilder.RegisterExternalTexture(DisplacementMap));
+
+		Entry = &Entries.Add(Key);
+		Entry->DisplacementMap = DisplacementMap;
+		Entry->SizeInBytes = SizeInBytes;
+		TotalSizeInBytes += SizeInBytes;
+		INC_MEMORY_STAT_BY(STAT_ShaderTest_DisplacementCacheMemory, SizeInBytes);
+	}
+	Entry->LastUsed = ++UseCounter;
+
+	return *Entry;
+}
+
+
+void FLensDistortionDisplacementCache::Empty()
+{
+	DEC_MEMORY_STAT_BY(STAT_ShaderTest_DisplacementCacheMemory, TotalSizeInBytes);
+	Entries.Empty();
+	TotalSizeInBytes = 0;
+}
+
+
+void FLensDistortionDisplacementCache::ReleaseRHI()
+{
+	Empty();
+}
+
+
+void FLensDistortionDisplacementCache::EvictToBudget(uint64 BudgetInBytes)
+{
+	while (TotalSizeInBytes > BudgetInBytes && Entries.Num() > 0)
+	{
+		const TPair<FKey, FEntry>* LeastRecentlyUsed = nullptr;
+		for (const TPair<FKey, FEntry>& Pair : Entries)
+		{
+			if (!LeastRecentlyUsed || Pair.Value.LastUsed < LeastRecentlyUsed->Value.LastUsed)
+			{
+				LeastRecentlyUsed = &Pair;
+			}
+		}
+
+		TotalSizeInBytes -= LeastRecentlyUsed->Value.SizeInBytes;
+		DEC_MEMORY_STAT_BY(STAT_ShaderTest_DisplacementCacheMemory, LeastRecentlyUsed->Value.SizeInBytes);
+		Entries.Remove(FKey(LeastRecentlyUsed->Key));
+	}
+}
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderResource.h"
+#include "RendererInterface.h"
+#include "LensDistortionRendering.h"
+
+
+/**
+ * Render thread LRU cache of the generated UV displacement maps, keyed on the compiled camera model,
+ * the resolution, the pixel format and the sRGB writes of the render target.
+ *
+ * The memory budget is set with r.ShaderTest.LensDistortion.CacheBudgetMB, 0 disables the cache.
+ * Changing the grid or compute cvars of the generation empties the cache, so the maps drawn after use the new settings.
+ */
+class FLensDistortionDisplacementCache : public FRenderResource
+{
+public:
+	/** Adds the passes copying the displacement map from the cache into the render target,
+	 *  calling GenerateDisplacement(Texture) to add the passes drawing it on a miss.
+	 *  The copy is added on every call, other draws may have written the render target since the previous one.
+	 */
+	void AddDrawUVDisplacementPasses(
+		FRDGBuilder& GraphBuilder,
+		const FCompiledCameraModel& CompiledCameraModel,
+		FRHITexture2D* RenderTargetTexture,
+		TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement);
+
+	/** Returns the displacement map of that resolution and pixel format from the cache, to be read by the passes of the graph,
+	 *  calling GenerateDisplacement(Texture) to add the passes drawing it on a miss. The map is transient when over the budget.
+	 */
+	FRDGTextureRef AddGetUVDisplacementPasses(
+		FRDGBuilder& GraphBuilder,
+		const FCompiledCameraModel& CompiledCameraModel,
+		FIntPoint Resolution,
+		EPixelFormat Format,
+		TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement);
+
+	/** Forgets every cached displacement map. */
+	void Empty();
+
+	// FRenderResource interface.
+	virtual void ReleaseRHI() override;
+
+private:
+	struct FKey
+	{
+		/** K1, K2, K3, P1, P2, the camera matrices and the output multiply and add, as sent to the shaders. */
+		float Model[15];
+		FIntPoint Resolution;
+		EPixelFormat Format;
+		/** The single direction of the camera model matters to the two channel formats. */
+		ELensDistortionDisplacementEncoding Encoding;
+		/** The map is drawn through an sRGB render target view, so that its copy into an sRGB render target decodes back to the displacements. */
+		bool bSRGB;
+
+		FKey(const FCompiledCameraModel& CompiledCameraModel, FIntPoint InResolution, EPixelFormat InFormat, bool bInSRGB);
+		FKey(const FCompiledCameraModel& CompiledCameraModel, FRHITexture2D* Texture);
+
+		/** A UAV when the compute pass generates the map, else a render target for the grid pass. */
+		ETextureCreateFlags GetTargetableFlags() const;
+
+		uint64 GetSizeInBytes() const
+		{
+			return uint64(Resolution.X) * Resolution.Y * GPixelFormats[Format].BlockBytes;
+		}
+
+		bool operator==(const FKey& Other) const
+		{
+			return FMemory::Memcmp(Model, Other.Model, sizeof(Model)) == 0 && Resolution == Other.Resolution && Format == Other.Format && Encoding == Other.Encoding && bSRGB == Other.bSRGB;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(FCrc::MemCrc32(Key.Model, sizeof(Key.Model)), HashCombine(GetTypeHash(Key.Resolution), uint32(Key.Format) | (uint32(Key.Encoding) << 16) | (uint32(Key.bSRGB) << 24)));
+		}
+	};
+
+	struct FEntry
+	{
+		TRefCountPtr<IPooledRenderTarget> DisplacementMap;
+		uint64 SizeInBytes = 0;
+		uint64 LastUsed = 0;
+	};
+
+	/** Cached map of the key, generated on a miss, the key must fit in the budget. */
+	FEntry& FindOrAddEntry(
+		FRDGBuilder& GraphBuilder,
+		const FKey& Key,
+		uint64 BudgetInBytes,
+		TFunctionRef<void(FRDGTextureRef Texture)> GenerateDisplacement);
+
+	void EvictToBudget(uint64 BudgetInBytes);
+
+	TMap<FKey, FEntry> Entries;
+	uint64 TotalSizeInBytes = 0;
+	uint64 UseCounter = 0;
+};
+
+extern TGlobalResource<FLensDistortionDisplacementCache> GLensDistortionDisplacementCache;
@@ -1,9 +1,18 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
-#include "LensDistortionAPI.h"
-
-
+#include "GlobalShaderExample/LensDistortionAPI.h"
+#include "LensDistortionRendering.h"
+#include "LensDistortionDisplacementCache.h"
+#include "LensDistortionAnimatedDisplacement.h"
+#include "LensDistortionCPU.h"
+#include "ShaderTestPasses.h"
+#include "Common/ShaderTestFrameGraph.h"
+#include "Common/ShaderTestPassProfiler.h"
+#include "Common/TestShaderUtils.h"
+
+#include "Engine/Texture.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTarget2DArray.h"
 #include "Engine/World.h"
 #include "GlobalShader.h"
 #include "PipelineStateCache.h"
@@ -11,37 +20,57 @@
 #include "SceneUtils.h"
 #include "SceneInterface.h"
 #include "ShaderParameterUtils.h"
+#include "ShaderParameterStruct.h"
+#include "RenderGraphUtils.h"
 #include "Logging/MessageLog.h"
 #include "Internationalization/Internationalization.h"
 
 
-static const uint32 kGridSubdivisionX = 32;
-static const uint32 kGridSubdivisionY = 16;
-
-#define LOCTEXT_NAMESPACE "LensDistortionPlugin"
+/** Upper bound of the grid cells along each axis. */
+static const int32 kMaxGridSubdivision = 256;
 
+/** Cells along each axis of the probes estimating the curvature of the undistortion. */
+static const int32 kGridCurvatureProbes = 16;
 
-/**
- * Internal intermediary structure derived from FFooCameraModel by the game thread
- * to hand to the render thread.
- */
-PRAGMA_DISABLE_DEPRECATION_WARNINGS
-struct FCompiledCameraModel
+/** The cvars picking how the maps are generated are not part of the displacement cache key, the cached maps are dropped instead. */
+static void OnDisplacementGenerationChanged(IConsoleVariable* Var)
 {
-	/** Orignal camera model that has generated this compiled model. */
-	FFooCameraModel OriginalCameraModel;
+	ENQUEUE_RENDER_COMMAND(EmptyLensDistortionDisplacementCache)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			GLensDistortionDisplacementCache.Empty();
+		});
+}
 
-	/** Camera matrices of the lens distortion for the undistorted and distorted render.
-	 *  XY holds the scales factors, ZW holds the translates.
-	 */
-	FVector4 DistortedCameraMatrix;
-	FVector4 UndistortedCameraMatrix;
+static TAutoConsoleVariable<float> CVarLensDistortionGridTolerance(
+	TEXT("r.ShaderTest.LensDistortion.GridTolerance"),
+	0.05f,
+	TEXT("Largest interpolation error in pixels of the grid pass, its density is picked per camera model and render target resolution\n")
+	TEXT("from a CPU estimate of the lens curvature, so that it draws the fewest triangles within the tolerance."),
+	FConsoleVariableDelegate::CreateStatic(&OnDisplacementGenerationChanged),
+	ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<int32> CVarLensDistortionGridSubdivision(
+	TEXT("r.ShaderTest.LensDistortion.GridSubdivision"),
+	0,
+	TEXT("Forces the cells of the grid pass along each axis, 0 picks them from r.ShaderTest.LensDistortion.GridTolerance."),
+	FConsoleVariableDelegate::CreateStatic(&OnDisplacementGenerationChanged),
+	ECVF_RenderThreadSafe);
+
+static TAutoConsoleVariable<int32> CVarLensDistortionUseCompute(
+	TEXT("r.ShaderTest.LensDistortion.UseCompute"),
+	0,
+	TEXT("Draws the UV displacement maps with a compute pass evaluating both directions per texel, instead of rasterizing the grid.\n")
+	TEXT("The maps are generated into the UAV textures of the displacement cache, so this applies to any render target whose format has\n")
+	TEXT("typed UAV stores and is not sRGB, the other maps are drawn by the grid pass through a render target view.\n")
+	TEXT("A map drawn directly, past r.ShaderTest.LensDistortion.CacheBudgetMB, uses the compute pass only when its render target has bCanCreateUAV."),
+	FConsoleVariableDelegate::CreateStatic(&OnDisplacementGenerationChanged),
+	ECVF_RenderThreadSafe);
 
-	/** Output multiply and add of the channel to the render target. */
-	FVector2D OutputMultiplyAndAdd;
-};
+#define LOCTEXT_NAMESPACE "LensDistortionPlugin"
 
 
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
 /** Undistorts top left originated viewport UV into the view space (x', y', z'=1.f) */
 static FVector2D LensUndistortViewportUVIntoViewSpace(
 	const FFooCameraModel& CameraModel,
@@ -66,8 +95,6 @@ public:
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
 	{
 		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
-		OutEnvironment.SetDefine(TEXT("GRID_SUBDIVISION_X"), kGridSubdivisionX);
-		OutEnvironment.SetDefine(TEXT("GRID_SUBDIVISION_Y"), kGridSubdivisionY);
 	}
 
 	FLensDistortionUVGenerationShader() {}
@@ -81,14 +108,16 @@ public:
 		DistortedCameraMatrix.Bind(Initializer.ParameterMap, TEXT("DistortedCameraMatrix"));
 		UndistortedCameraMatrix.Bind(Initializer.ParameterMap, TEXT("UndistortedCameraMatrix"));
 		OutputMultiplyAndAdd.Bind(Initializer.ParameterMap, TEXT("OutputMultiplyAndAdd"));
+		GridSubdivision.Bind(Initializer.ParameterMap, TEXT("GridSubdivision"));
 	}
 
 	template<typename TShaderRHIParamRef>
 	void SetParameters(
-		FRHICommandListImmediate& RHICmdList,
+		FRHICommandList& RHICmdList,
 		const TShaderRHIParamRef ShaderRHI,
 		const FCompiledCameraModel& CompiledCameraModel,
-		const FIntPoint& DisplacementMapResolution)
+		const FIntPoint& DisplacementMapResolution,
+		const FIntPoint& GridSubdivisionValue)
 	{
 		FVector2f PixelUVSizeValue(
 			1.f / float(DisplacementMapResolution.X), 1.f / float(DisplacementMapResolution.Y));
@@ -106,6 +135,15 @@ public:
 		SetShaderValue(RHICmdList, ShaderRHI, RadialDistortionCoefs, RadialDistortionCoefsValue);
 		SetShaderValue(RHICmdList, ShaderRHI, TangentialDistortionCoefs, TangentialDistortionCoefsValue);
 		SetShaderValue(RHICmdList, ShaderRHI, OutputMultiplyAndAdd, FVector2f(CompiledCameraModel.OutputMultiplyAndAdd));
+		SetShaderValue(RHICmdList, ShaderRHI, GridSubdivision, GridSubdivisionValue);
+	}
+
+	/** Bytes SetParameters() uploads, the sizes of the parameters as bound by the shader compiler. */
+	uint32 GetParametersSize() const
+	{
+		return PixelUVSize.GetNumBytes() + RadialDistortionCoefs.GetNumBytes() + TangentialDistortionCoefs.GetNumBytes() +
+			DistortedCameraMatrix.GetNumBytes() + UndistortedCameraMatrix.GetNumBytes() + OutputMultiplyAndAdd.GetNumBytes() +
+			GridSubdivision.GetNumBytes();
 	}
 
 private:
@@ -116,6 +154,7 @@ private:
 	LAYOUT_FIELD(FShaderParameter, DistortedCameraMatrix);
 	LAYOUT_FIELD(FShaderParameter, UndistortedCameraMatrix);
 	LAYOUT_FIELD(FShaderParameter, OutputMultiplyAndAdd);
+	LAYOUT_FIELD(FShaderParameter, GridSubdivision);
 };
 
 
@@ -135,11 +174,28 @@ public:
 };
 
 
+/** Channels written by the pixel and compute shaders, see EncodeDisplacement(). */
+class FLensDistortionEncodingDim : SHADER_PERMUTATION_ENUM_CLASS("DISPLACEMENT_ENCODING", ELensDistortionDisplacementEncoding);
+
+
 class FLensDistortionUVGenerationPS : public FLensDistortionUVGenerationShader
 {
 	DECLARE_SHADER_TYPE(FLensDistortionUVGenerationPS, Global);
 public:
 
+	using FPermutationDomain = TShaderPermutationDomain<FLensDistortionEncodingDim>;
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FLensDistortionUVGenerationShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		if (PermutationVector.Get<FLensDistortionEncodingDim>() == ELensDistortionDisplacementEncoding::PackedHalf)
+		{
+			OutEnvironment.SetRenderTargetOutputFormat(0, PF_R32G32_UINT);
+		}
+	}
+
 	/** Default constructor. */
 	FLensDistortionUVGenerationPS() {}
 
@@ -154,6 +210,382 @@ IMPLEMENT_SHADER_TYPE(, FLensDistortionUVGenerationVS, TEXT("/Plugin/ShaderTest/
 IMPLEMENT_SHADER_TYPE(, FLensDistortionUVGenerationPS, TEXT("/Plugin/ShaderTest/Private/GlobalShaderExample.usf"), TEXT("MainPS"), SF_Pixel)
 
 
+class FLensDistortionUVGenerationCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FLensDistortionUVGenerationCS);
+	SHADER_USE_PARAMETER_STRUCT(FLensDistortionUVGenerationCS, FGlobalShader);
+
+	using FPermutationDomain = TShaderPermutationDomain<FLensDistortionEncodingDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FVector2f, PixelUVSize)
+		SHADER_PARAMETER(FIntPoint, OutputSize)
+		SHADER_PARAMETER(FVector3f, RadialDistortionCoefs)
+		SHADER_PARAMETER(FVector2f, TangentialDistortionCoefs)
+		SHADER_PARAMETER(FVector4f, DistortedCameraMatrix)
+		SHADER_PARAMETER(FVector4f, UndistortedCameraMatrix)
+		SHADER_PARAMETER(FVector2f, OutputMultiplyAndAdd)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutDisplacement)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static constexpr int32 kThreadGroupSize = 8;
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		// Shares GlobalShaderExample.usf with the grid pass.
+		FLensDistortionUVGenerationShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), kThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FLensDistortionUVGenerationCS, "/Plugin/ShaderTest/Private/GlobalShaderExample.usf", "MainCS", SF_Compute);
+
+
+/** Per camera parameters of FLensDistortionUVGenerationArrayCS, matches FLensDistortionArrayCamera of GlobalShaderExample.usf. */
+struct FLensDistortionArrayCamera
+{
+	FVector4f UndistortedCameraMatrix;
+	FVector4f DistortedCameraMatrix;
+	FVector3f RadialDistortionCoefs;
+	FVector2f TangentialDistortionCoefs;
+	FVector2f OutputMultiplyAndAdd;
+	float Padding = 0.0f;
+};
+
+static_assert(sizeof(FLensDistortionArrayCamera) == 16 * sizeof(float), "FLensDistortionArrayCamera must match the tightly packed structure of the shader.");
+
+
+class FLensDistortionUVGenerationArrayCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FLensDistortionUVGenerationArrayCS);
+	SHADER_USE_PARAMETER_STRUCT(FLensDistortionUVGenerationArrayCS, FGlobalShader);
+
+	using FPermutationDomain = TShaderPermutationDomain<FLensDistortionEncodingDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FVector2f, PixelUVSize)
+		SHADER_PARAMETER(FIntPoint, OutputSize)
+		SHADER_PARAMETER(uint32, NumCameras)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FLensDistortionArrayCamera>, Cameras)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2DArray<float4>, OutDisplacementArray)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FLensDistortionUVGenerationCS::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FLensDistortionUVGenerationArrayCS, "/Plugin/ShaderTest/Private/GlobalShaderExample.usf", "MainArrayCS", SF_Compute);
+
+
+ELensDistortionDisplacementEncoding GetUVDisplacementEncoding(EPixelFormat Format, ELensDistortionApplyMode SingleDirection)
+{
+	switch (Format)
+	{
+	case PF_R32G32_UINT:
+		return ELensDistortionDisplacementEncoding::PackedHalf;
+	case PF_G16R16F:
+	case PF_G16R16F_FILTER:
+	case PF_G32R32F:
+		return SingleDirection == ELensDistortionApplyMode::Undistort ? ELensDistortionDisplacementEncoding::UndistortRG : ELensDistortionDisplacementEncoding::DistortRG;
+	default:
+		return ELensDistortionDisplacementEncoding::RGBA;
+	}
+}
+
+
+bool IsUVDisplacementNormalizedFormat(EPixelFormat Format)
+{
+	return Format == PF_B8G8R8A8 || Format == PF_R8G8B8A8;
+}
+
+
+bool CanWriteUVDisplacementWithCompute(EPixelFormat Format, bool bSRGB)
+{
+	return !bSRGB && RHIIsTypedUAVStoreSupported(Format);
+}
+
+
+bool ShouldGenerateUVDisplacementWithCompute(EPixelFormat Format, bool bSRGB)
+{
+	return CVarLensDistortionUseCompute.GetValueOnRenderThread() != 0 && CanWriteUVDisplacementWithCompute(Format, bSRGB);
+}
+
+
+void AddLensDistortionUVDisplacementPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FCompiledCameraModel& CompiledCameraModel,
+	FRDGTextureRef OutputTexture,
+	ERDGPassFlags PassFlags)
+{
+	const FIntPoint DisplacementMapResolution = OutputTexture->Desc.Extent;
+
+	FLensDistortionUVGenerationCS::FParameters* Parameters = GraphBuilder.AllocParameters<FLensDistortionUVGenerationCS::FParameters>();
+	Parameters->PixelUVSize = FVector2f(1.f / float(DisplacementMapResolution.X), 1.f / float(DisplacementMapResolution.Y));
+	Parameters->OutputSize = DisplacementMapResolution;
+	Parameters->RadialDistortionCoefs = FVector3f(
+		CompiledCameraModel.OriginalCameraModel.K1,
+		CompiledCameraModel.OriginalCameraModel.K2,
+		CompiledCameraModel.OriginalCameraModel.K3);
+	Parameters->TangentialDistortionCoefs = FVector2f(
+		CompiledCameraModel.OriginalCameraModel.P1,
+		CompiledCameraModel.OriginalCameraModel.P2);
+	Parameters->DistortedCameraMatrix = FVector4f(CompiledCameraModel.DistortedCameraMatrix);
+	Parameters->UndistortedCameraMatrix = FVector4f(CompiledCameraModel.UndistortedCameraMatrix);
+	Parameters->OutputMultiplyAndAdd = FVector2f(CompiledCameraModel.OutputMultiplyAndAdd);
+	Parameters->OutDisplacement = GraphBuilder.CreateUAV(OutputTexture);
+
+	FLensDistortionUVGenerationCS::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FLensDistortionEncodingDim>(GetUVDisplacementEncoding(OutputTexture->Desc.Format, CompiledCameraModel.SingleDirection));
+
+	TShaderMapRef<FLensDistortionUVGenerationCS> ComputeShader(GetGlobalShaderMap(FeatureLevel), PermutationVector);
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("LensDistortionDisplacementGeneration %dx%d", DisplacementMapResolution.X, DisplacementMapResolution.Y),
+		PassFlags,
+		ComputeShader,
+		Parameters,
+		FComputeShaderUtils::GetGroupCount(DisplacementMapResolution, FLensDistortionUVGenerationCS::kThreadGroupSize));
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::LensDistortion, sizeof(FLensDistortionUVGenerationCS::FParameters));
+}
+
+
+void AddLensDistortionUVDisplacementArrayPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	TConstArrayView<FCompiledCameraModel> CompiledCameraModels,
+	FRDGTextureRef OutputTextureArray,
+	ERDGPassFlags PassFlags)
+{
+	check(CompiledCameraModels.Num() > 0 && CompiledCameraModels.Num() <= OutputTextureArray->Desc.ArraySize);
+
+	const FIntPoint DisplacementMapResolution = OutputTextureArray->Desc.Extent;
+
+	TArray<FLensDistortionArrayCamera> Cameras;
+	Cameras.SetNum(CompiledCameraModels.Num());
+	for (int32 CameraIndex = 0; CameraIndex < CompiledCameraModels.Num(); CameraIndex++)
+	{
+		const FCompiledCameraModel& CompiledCameraModel = CompiledCameraModels[CameraIndex];
+		FLensDistortionArrayCamera& Camera = Cameras[CameraIndex];
+		Camera.UndistortedCameraMatrix = FVector4f(CompiledCameraModel.UndistortedCameraMatrix);
+		Camera.DistortedCameraMatrix = FVector4f(CompiledCameraModel.DistortedCameraMatrix);
+		Camera.RadialDistortionCoefs = FVector3f(
+			CompiledCameraModel.OriginalCameraModel.K1,
+			CompiledCameraModel.OriginalCameraModel.K2,
+			CompiledCameraModel.OriginalCameraModel.K3);
+		Camera.TangentialDistortionCoefs = FVector2f(
+			CompiledCameraModel.OriginalCameraModel.P1,
+			CompiledCameraModel.OriginalCameraModel.P2);
+		Camera.OutputMultiplyAndAdd = FVector2f(CompiledCameraModel.OutputMultiplyAndAdd);
+	}
+
+	FRDGBufferRef CamerasBuffer = CreateStructuredBuffer(GraphBuilder, TEXT("LensDistortionCameras"),
+		sizeof(FLensDistortionArrayCamera), Cameras.Num(), Cameras.GetData(), Cameras.Num() * sizeof(FLensDistortionArrayCamera));
+
+	FLensDistortionUVGenerationArrayCS::FParameters* Parameters = GraphBuilder.AllocParameters<FLensDistortionUVGenerationArrayCS::FParameters>();
+	Parameters->PixelUVSize = FVector2f(1.f / float(DisplacementMapResolution.X), 1.f / float(DisplacementMapResolution.Y));
+	Parameters->OutputSize = DisplacementMapResolution;
+	Parameters->NumCameras = Cameras.Num();
+	Parameters->Cameras = GraphBuilder.CreateSRV(CamerasBuffer);
+	Parameters->OutDisplacementArray = GraphBuilder.CreateUAV(OutputTextureArray);
+
+	FLensDistortionUVGenerationArrayCS::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FLensDistortionEncodingDim>(GetUVDisplacementEncoding(OutputTextureArray->Desc.Format, CompiledCameraModels[0].SingleDirection));
+
+	// One slice per thread group Z.
+	const FIntVector GroupCount = FComputeShaderUtils::GetGroupCount(
+		FIntVector(DisplacementMapResolution.X, DisplacementMapResolution.Y, Cameras.Num()),
+		FIntVector(FLensDistortionUVGenerationCS::kThreadGroupSize, FLensDistortionUVGenerationCS::kThreadGroupSize, 1));
+
+	TShaderMapRef<FLensDistortionUVGenerationArrayCS> ComputeShader(GetGlobalShaderMap(FeatureLevel), PermutationVector);
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("LensDistortionDisplacementArrayGeneration %dx%dx%d", DisplacementMapResolution.X, DisplacementMapResolution.Y, Cameras.Num()),
+		PassFlags,
+		ComputeShader,
+		Parameters,
+		GroupCount);
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::LensDistortion,
+		sizeof(FLensDistortionUVGenerationArrayCS::FParameters) + Cameras.Num() * sizeof(FLensDistortionArrayCamera));
+}
+
+
+/** Cells of the grid pass along X and Y, the fewest keeping the linear interpolation error of the grid within
+ *  r.ShaderTest.LensDistortion.GridTolerance pixels at this resolution.
+ *
+ *  The grid is regular in the distorted viewport and its vertices are undistorted, so within a cell of size (Hx, Hy) the
+ *  triangles deviate from the undistortion by about (Fxx * Hx^2 + 2 * Fxy * Hx * Hy + Fyy * Hy^2) / 8, from its largest
+ *  second derivatives in pixels, estimated with finite differences over probes covering the viewport.
+ */
+static FIntPoint GetUVDisplacementGridSubdivision(const FCompiledCameraModel& CompiledCameraModel, FIntPoint Resolution)
+{
+	const int32 ForcedSubdivision = CVarLensDistortionGridSubdivision.GetValueOnRenderThread();
+	if (ForcedSubdivision > 0)
+	{
+		const int32 Subdivision = FMath::Min(ForcedSubdivision, kMaxGridSubdivision);
+		return FIntPoint(Subdivision, Subdivision);
+	}
+
+	const FFooCameraModel& CameraModel = CompiledCameraModel.OriginalCameraModel;
+	const FVector4& DistortedCameraMatrix = CompiledCameraModel.DistortedCameraMatrix;
+	const FVector4& UndistortedCameraMatrix = CompiledCameraModel.UndistortedCameraMatrix;
+
+	// UndistortViewportUV() of LensDistortion.ush, in pixels.
+	auto UndistortViewportPixel = [&](double U, double V)
+	{
+		const double X = (U - DistortedCameraMatrix.Z) / DistortedCameraMatrix.X;
+		const double Y = (V - DistortedCameraMatrix.W) / DistortedCameraMatrix.Y;
+		const double R2 = X * X + Y * Y;
+		const double Radial = 1.0 + R2 * (CameraModel.K1 + R2 * (CameraModel.K2 + R2 * CameraModel.K3));
+		const double UndistortedX = X * Radial + CameraModel.P2 * (R2 + 2.0 * X * X) + 2.0 * CameraModel.P1 * X * Y;
+		const double UndistortedY = Y * Radial + CameraModel.P1 * (R2 + 2.0 * Y * Y) + 2.0 * CameraModel.P2 * X * Y;
+		return FVector2D(
+			(UndistortedCameraMatrix.X * UndistortedX + UndistortedCameraMatrix.Z) * Resolution.X,
+			(UndistortedCameraMatrix.Y * UndistortedY + UndistortedCameraMatrix.W) * Resolution.Y);
+	};
+
+	// Largest second derivatives over the viewport UVs, the probes on the border use samples one step outside.
+	const double Step = 1.0 / kGridCurvatureProbes;
+	double Fxx = 0.0;
+	double Fxy = 0.0;
+	double Fyy = 0.0;
+	for (int32 ProbeY = 0; ProbeY <= kGridCurvatureProbes; ProbeY++)
+	{
+		for (int32 ProbeX = 0; ProbeX <= kGridCurvatureProbes; ProbeX++)
+		{
+			const double U = ProbeX * Step;
+			const double V = ProbeY * Step;
+			const FVector2D Center = UndistortViewportPixel(U, V);
+
+			Fxx = FMath::Max(Fxx, (UndistortViewportPixel(U + Step, V) - 2.0 * Center + UndistortViewportPixel(U - Step, V)).Size());
+			Fyy = FMath::Max(Fyy, (UndistortViewportPixel(U, V + Step) - 2.0 * Center + UndistortViewportPixel(U, V - Step)).Size());
+			Fxy = FMath::Max(Fxy, 0.25 * (
+				UndistortViewportPixel(U + Step, V + Step) - UndistortViewportPixel(U + Step, V - Step) -
+				UndistortViewportPixel(U - Step, V + Step) + UndistortViewportPixel(U - Step, V - Step)).Size());
+		}
+	}
+	Fxx /= Step * Step;
+	Fxy /= Step * Step;
+	Fyy /= Step * Step;
+
+	const double Tolerance = FMath::Max(double(CVarLensDistortionGridTolerance.GetValueOnRenderThread()), 1.e-3);
+	auto GetError = [&](int32 CellsX, int32 CellsY)
+	{
+		const double Hx = 1.0 / CellsX;
+		const double Hy = 1.0 / CellsY;
+		return (Fxx * Hx * Hx + 2.0 * Fxy * Hx * Hy + Fyy * Hy * Hy) / 8.0;
+	};
+
+	// Each axis within the tolerance on its own, then the axis with the largest error is refined until the cross term fits too.
+	FIntPoint Subdivision(
+		FMath::Clamp(FMath::CeilToInt(float(FMath::Sqrt(Fxx / (8.0 * Tolerance)))), 1, kMaxGridSubdivision),
+		FMath::Clamp(FMath::CeilToInt(float(FMath::Sqrt(Fyy / (8.0 * Tolerance)))), 1, kMaxGridSubdivision));
+
+	while (GetError(Subdivision.X, Subdivision.Y) > Tolerance && (Subdivision.X < kMaxGridSubdivision || Subdivision.Y < kMaxGridSubdivision))
+	{
+		const bool bRefineX = Subdivision.Y >= kMaxGridSubdivision ||
+			(Subdivision.X < kMaxGridSubdivision && Fxx / FMath::Square(double(Subdivision.X)) >= Fyy / FMath::Square(double(Subdivision.Y)));
+		(bRefineX ? Subdivision.X : Subdivision.Y)++;
+	}
+
+	return Subdivision;
+}
+
+
+static void AddUVDisplacementGridPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FCompiledCameraModel& CompiledCameraModel,
+	FRDGTextureRef OutputTexture)
+{
+	const FIntPoint DisplacementMapResolution = OutputTexture->Desc.Extent;
+	const FIntPoint GridSubdivision = GetUVDisplacementGridSubdivision(CompiledCameraModel, DisplacementMapResolution);
+
+	FLensDistortionUVGenerationPS::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FLensDistortionEncodingDim>(GetUVDisplacementEncoding(OutputTexture->Desc.Format, CompiledCameraModel.SingleDirection));
+
+	// Get shaders.
+	FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+	TShaderMapRef< FLensDistortionUVGenerationVS > VertexShader(GlobalShaderMap);
+	TShaderMapRef< FLensDistortionUVGenerationPS > PixelShader(GlobalShaderMap, PermutationVector);
+
+	FRenderTargetParameters* Parameters = GraphBuilder.AllocParameters<FRenderTargetParameters>();
+	Parameters->RenderTargets[0] = FRenderTargetBinding(OutputTexture, ERenderTargetLoadAction::ENoAction);
+
+	GraphBuilder.AddPass(
+		RDG_EVENT_NAME("LensDistortionDisplacementGeneration %dx%d, grid %dx%d",
+			DisplacementMapResolution.X, DisplacementMapResolution.Y, GridSubdivision.X, GridSubdivision.Y),
+		Parameters,
+		ERDGPassFlags::Raster,
+		[VertexShader, PixelShader, CompiledCameraModel, DisplacementMapResolution, GridSubdivision](FRHICommandList& RHICmdList)
+		{
+			// Set the graphic pipeline state.
+			FGraphicsPipelineStateInitializer GraphicsPSOInit;
+			RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+			GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+			GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+			GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+			GraphicsPSOInit.PrimitiveType = PT_TriangleList;
+			GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GetVertexDeclarationFVector4();
+			GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+			GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+			SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
+
+			// Update viewport.
+			RHICmdList.SetViewport(
+				0, 0, 0.f,
+				DisplacementMapResolution.X, DisplacementMapResolution.Y, 1.f);
+
+			// Update shader uniform parameters.
+			VertexShader->SetParameters(RHICmdList, VertexShader.GetVertexShader(), CompiledCameraModel, DisplacementMapResolution, GridSubdivision);
+			PixelShader->SetParameters(RHICmdList, PixelShader.GetPixelShader(), CompiledCameraModel, DisplacementMapResolution, GridSubdivision);
+
+			// Draw grid.
+			uint32 PrimitiveCount = GridSubdivision.X * GridSubdivision.Y * 2;
+			RHICmdList.DrawPrimitive(0, PrimitiveCount, 1);
+		});
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::LensDistortion, VertexShader->GetParametersSize() + PixelShader->GetParametersSize());
+}
+
+
+static void AddUVDisplacementGenerationPasses(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FCompiledCameraModel& CompiledCameraModel,
+	FRDGTextureRef OutputTexture)
+{
+	if (ShouldGenerateUVDisplacementWithCompute(OutputTexture->Desc.Format, EnumHasAnyFlags(OutputTexture->Desc.Flags, TexCreate_SRGB))
+		&& EnumHasAnyFlags(OutputTexture->Desc.Flags, TexCreate_UAV))
+	{
+		AddLensDistortionUVDisplacementPass(GraphBuilder, FeatureLevel, CompiledCameraModel, OutputTexture);
+	}
+	else
+	{
+		AddUVDisplacementGridPass(GraphBuilder, FeatureLevel, CompiledCameraModel, OutputTexture);
+	}
+}
+
+
 static void DrawUVDisplacementToRenderTarget_RenderThread(
 	FRHICommandListImmediate& RHICmdList,
 	const FCompiledCameraModel& CompiledCameraModel,
@@ -163,61 +595,275 @@ static void DrawUVDisplacementToRenderTarget_RenderThread(
 {
 	check(IsInRenderingThread());
 
-#if WANTS_DRAW_MESH_EVENTS
-// 	FString EventName;
-// 	TextureRenderTargetName.ToString(EventName);
-// 	SCOPED_DRAW_EVENTF(RHICmdList, SceneCapture, TEXT("LensDistortionDisplacementGeneration %s"), *EventName);
-#else
-	SCOPED_DRAW_EVENT(RHICmdList, DrawUVDisplacementToRenderTarget_RenderThread);
-#endif
-
-	FRHITexture2D* RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
-
-	RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::SRVMask, ERHIAccess::RTV));
-
-	FRHIRenderPassInfo RPInfo(RenderTargetTexture, ERenderTargetActions::DontLoad_Store);
-	RHICmdList.BeginRenderPass(RPInfo, TEXT("DrawUVDisplacement"));
-	{
-		FIntPoint DisplacementMapResolution(OutTextureRenderTargetResource->GetSizeX(), OutTextureRenderTargetResource->GetSizeY());
-
-		// Update viewport.
-		RHICmdList.SetViewport(
-			0, 0, 0.f,
-			DisplacementMapResolution.X, DisplacementMapResolution.Y, 1.f);
-
-		// Get shaders.
-		FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
-		TShaderMapRef< FLensDistortionUVGenerationVS > VertexShader(GlobalShaderMap);
-		TShaderMapRef< FLensDistortionUVGenerationPS > PixelShader(GlobalShaderMap);
-
-		// Set the graphic pipeline state.
-		FGraphicsPipelineStateInitializer GraphicsPSOInit;
-		RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
-		GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
-		GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
-		GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
-		GraphicsPSOInit.PrimitiveType = PT_TriangleList;
-		GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GetVertexDeclarationFVector4();
-		GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
-		GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
-		SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
-
-		// Update viewport.
-		RHICmdList.SetViewport(
-			0, 0, 0.f,
-			OutTextureRenderTargetResource->GetSizeX(), OutTextureRenderTargetResource->GetSizeY(), 1.f);
-
-		// Update shader uniform parameters.
-		VertexShader->SetParameters(RHICmdList, VertexShader.GetVertexShader(), CompiledCameraModel, DisplacementMapResolution);
-		PixelShader->SetParameters(RHICmdList, PixelShader.GetPixelShader(), CompiledCameraModel, DisplacementMapResolution);
-
-		// Draw grid.
-		uint32 PrimitiveCount = kGridSubdivisionX * kGridSubdivisionY * 2;
-		RHICmdList.DrawPrimitive(0, PrimitiveCount, 1);
-	}
-	RHICmdList.EndRenderPass();
-
-	RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::RTV, ERHIAccess::SRVMask));
+	SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+
+	FTexture2DRHIRef RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
+
+	FShaderTestFrameGraph::AddPasses(RHICmdList, [CompiledCameraModel, RenderTargetTexture, FeatureLevel](FRDGBuilder& GraphBuilder)
+	{
+		SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+		SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, LensDistortion);
+
+		GLensDistortionDisplacementCache.AddDrawUVDisplacementPasses(GraphBuilder, CompiledCameraModel, RenderTargetTexture,
+			[&GraphBuilder, &CompiledCameraModel, FeatureLevel](FRDGTextureRef Texture)
+			{
+				AddUVDisplacementGenerationPasses(GraphBuilder, FeatureLevel, CompiledCameraModel, Texture);
+			});
+	});
+}
+
+
+void AddLensDistortionDisplacementMapPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	float OutputMultiply,
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection)
+{
+	SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+	SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, LensDistortion);
+
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::CompileForFormat(
+		CameraModel, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputTexture->Desc.Format, OutputMultiply, OutputAdd, SingleDirection);
+
+	FRDGTextureRef DisplacementMap = GLensDistortionDisplacementCache.AddGetUVDisplacementPasses(
+		GraphBuilder, CompiledCameraModel, OutputTexture->Desc.Extent, OutputTexture->Desc.Format,
+		[&GraphBuilder, &CompiledCameraModel, FeatureLevel](FRDGTextureRef Texture)
+		{
+			AddUVDisplacementGenerationPasses(GraphBuilder, FeatureLevel, CompiledCameraModel, Texture);
+		});
+
+	AddCopyTexturePass(GraphBuilder, DisplacementMap, OutputTexture);
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+}
+
+
+static void DrawUVDisplacementsToRenderTargetArray_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	TArray<FCompiledCameraModel>&& CompiledCameraModels,
+	FTextureRenderTargetResource* OutTextureRenderTargetResource,
+	ERHIFeatureLevel::Type FeatureLevel)
+{
+	check(IsInRenderingThread());
+
+	SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+
+	FTextureRHIRef RenderTargetTexture = OutTextureRenderTargetResource->TextureRHI;
+
+	FShaderTestFrameGraph::AddPasses(RHICmdList,
+		[CompiledCameraModels = MoveTemp(CompiledCameraModels), RenderTargetTexture, FeatureLevel](FRDGBuilder& GraphBuilder)
+	{
+		SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+		SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, LensDistortion);
+
+		FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("LensDistortionDisplacementArray")));
+		GraphBuilder.SetTextureAccessFinal(OutputTexture, ERHIAccess::SRVMask);
+
+		if (EnumHasAnyFlags(OutputTexture->Desc.Flags, TexCreate_UAV))
+		{
+			AddLensDistortionUVDisplacementArrayPass(GraphBuilder, FeatureLevel, CompiledCameraModels, OutputTexture);
+			return;
+		}
+
+		// Render target arrays are not created with UAV support, generated into a transient array copied over.
+		FRDGTextureRef DisplacementMaps = GraphBuilder.CreateTexture(
+			FRDGTextureDesc::Create2DArray(OutputTexture->Desc.Extent, OutputTexture->Desc.Format, FClearValueBinding::None,
+				TexCreate_ShaderResource | TexCreate_UAV, CompiledCameraModels.Num()),
+			TEXT("LensDistortionDisplacementArray"));
+		AddLensDistortionUVDisplacementArrayPass(GraphBuilder, FeatureLevel, CompiledCameraModels, DisplacementMaps);
+
+		FRHICopyTextureInfo CopyInfo;
+		CopyInfo.Size = FIntVector(OutputTexture->Desc.Extent.X, OutputTexture->Desc.Extent.Y, 1);
+		CopyInfo.NumSlices = CompiledCameraModels.Num();
+		AddCopyTexturePass(GraphBuilder, DisplacementMaps, OutputTexture, CopyInfo);
+		FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+	});
+}
+
+
+class FLensDistortionApplyVS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FLensDistortionApplyVS);
+	SHADER_USE_PARAMETER_STRUCT(FLensDistortionApplyVS, FGlobalShader);
+
+	using FParameters = FEmptyShaderParameters;
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+};
+
+
+class FLensDistortionApplyPS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FLensDistortionApplyPS);
+	SHADER_USE_PARAMETER_STRUCT(FLensDistortionApplyPS, FGlobalShader);
+
+	/** Samples the input at the distorted UV of the pixel, undistorting the image, instead of the undistorted one. */
+	class FUndistortDim : SHADER_PERMUTATION_BOOL("UNDISTORT");
+	/** Reads the displacement of the pixel from DisplacementMap instead of evaluating the lens. */
+	class FDisplacementMapDim : SHADER_PERMUTATION_BOOL("DISPLACEMENT_MAP");
+
+	using FPermutationDomain = TShaderPermutationDomain<FUndistortDim, FDisplacementMapDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FVector2f, PixelUVSize)
+		SHADER_PARAMETER(FVector3f, RadialDistortionCoefs)
+		SHADER_PARAMETER(FVector2f, TangentialDistortionCoefs)
+		SHADER_PARAMETER(FVector4f, DistortedCameraMatrix)
+		SHADER_PARAMETER(FVector4f, UndistortedCameraMatrix)
+		SHADER_PARAMETER(FVector2f, InputPixelUVSize)
+		SHADER_PARAMETER(FVector2f, InputUVScale)
+		SHADER_PARAMETER(FVector2f, InputUVBias)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, InputTexture)
+		SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, DisplacementMap)
+		RENDER_TARGET_BINDING_SLOTS()
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FLensDistortionApplyVS, "/Plugin/ShaderTest/Private/LensDistortionApply.usf", "MainVS", SF_Vertex);
+IMPLEMENT_GLOBAL_SHADER(FLensDistortionApplyPS, "/Plugin/ShaderTest/Private/LensDistortionApply.usf", "MainPS", SF_Pixel);
+
+
+void AddLensDistortionApplyPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FCompiledCameraModel& CompiledCameraModel,
+	ELensDistortionApplyMode Mode,
+	FRDGTextureRef InputTexture,
+	FIntRect InputViewRect,
+	FRDGTextureRef OutputTexture,
+	FIntRect OutputViewRect,
+	bool bUseDisplacementMap)
+{
+	const FIntPoint InputExtent = InputTexture->Desc.Extent;
+	const FIntPoint OutputSize = OutputViewRect.Size();
+
+	FLensDistortionApplyPS::FParameters* Parameters = GraphBuilder.AllocParameters<FLensDistortionApplyPS::FParameters>();
+	Parameters->PixelUVSize = FVector2f(1.f / float(OutputSize.X), 1.f / float(OutputSize.Y));
+	Parameters->RadialDistortionCoefs = FVector3f(
+		CompiledCameraModel.OriginalCameraModel.K1,
+		CompiledCameraModel.OriginalCameraModel.K2,
+		CompiledCameraModel.OriginalCameraModel.K3);
+	Parameters->TangentialDistortionCoefs = FVector2f(
+		CompiledCameraModel.OriginalCameraModel.P1,
+		CompiledCameraModel.OriginalCameraModel.P2);
+	Parameters->DistortedCameraMatrix = FVector4f(CompiledCameraModel.DistortedCameraMatrix);
+	Parameters->UndistortedCameraMatrix = FVector4f(CompiledCameraModel.UndistortedCameraMatrix);
+	Parameters->InputPixelUVSize = FVector2f(1.f / float(InputViewRect.Width()), 1.f / float(InputViewRect.Height()));
+	Parameters->InputUVScale = FVector2f(float(InputViewRect.Width()) / float(InputExtent.X), float(InputViewRect.Height()) / float(InputExtent.Y));
+	Parameters->InputUVBias = FVector2f(float(InputViewRect.Min.X) / float(InputExtent.X), float(InputViewRect.Min.Y) / float(InputExtent.Y));
+	Parameters->InputTexture = InputTexture;
+	Parameters->InputSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+
+	// The pass covers the whole view rect, the rest of the texture is kept.
+	const bool bWholeTexture = OutputViewRect.Min == FIntPoint::ZeroValue && OutputSize == OutputTexture->Desc.Extent;
+	Parameters->RenderTargets[0] = FRenderTargetBinding(OutputTexture, bWholeTexture ? ERenderTargetLoadAction::ENoAction : ERenderTargetLoadAction::ELoad);
+
+	if (bUseDisplacementMap)
+	{
+		// Raw displacements in viewport UV.
+		FCompiledCameraModel DisplacementCameraModel = CompiledCameraModel;
+		DisplacementCameraModel.OutputMultiplyAndAdd = FVector2D(1.0f, 0.0f);
+
+		Parameters->DisplacementMap = GLensDistortionDisplacementCache.AddGetUVDisplacementPasses(GraphBuilder, DisplacementCameraModel, OutputSize, PF_FloatRGBA,
+			[&GraphBuilder, &DisplacementCameraModel, FeatureLevel](FRDGTextureRef Texture)
+			{
+				AddUVDisplacementGenerationPasses(GraphBuilder, FeatureLevel, DisplacementCameraModel, Texture);
+			});
+	}
+
+	FLensDistortionApplyPS::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FLensDistortionApplyPS::FUndistortDim>(Mode == ELensDistortionApplyMode::Undistort);
+	PermutationVector.Set<FLensDistortionApplyPS::FDisplacementMapDim>(bUseDisplacementMap);
+
+	GraphBuilder.AddPass(
+		RDG_EVENT_NAME("LensDistortionApply %s %dx%d%s",
+			Mode == ELensDistortionApplyMode::Undistort ? TEXT("Undistort") : TEXT("Distort"),
+			OutputSize.X, OutputSize.Y, bUseDisplacementMap ? TEXT(", displacement map") : TEXT("")),
+		Parameters,
+		ERDGPassFlags::Raster,
+		[FeatureLevel, PermutationVector, OutputViewRect, Parameters](FRHICommandList& RHICmdList)
+		{
+			FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+			TShaderMapRef<FLensDistortionApplyVS> VertexShader(GlobalShaderMap);
+			TShaderMapRef<FLensDistortionApplyPS> PixelShader(GlobalShaderMap, PermutationVector);
+
+			FGraphicsPipelineStateInitializer GraphicsPSOInit;
+			RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+			GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+			GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+			GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+			GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+			GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+			UTestShaderUtils::SetupFullScreenTriangle(GraphicsPSOInit);
+			SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
+
+			RHICmdList.SetViewport(
+				OutputViewRect.Min.X, OutputViewRect.Min.Y, 0.f,
+				OutputViewRect.Max.X, OutputViewRect.Max.Y, 1.f);
+
+			SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), *Parameters);
+
+			UTestShaderUtils::DrawFullScreenTriangle(RHICmdList);
+		});
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::LensDistortion, 1);
+	FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::LensDistortion, sizeof(FLensDistortionApplyPS::FParameters));
+}
+
+
+static void ApplyToRenderTarget_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	const FCompiledCameraModel& CompiledCameraModel,
+	ELensDistortionApplyMode Mode,
+	bool bUseDisplacementMap,
+	FTextureReferenceRHIRef InputTextureReference,
+	FTextureRenderTargetResource* OutTextureRenderTargetResource,
+	ERHIFeatureLevel::Type FeatureLevel)
+{
+	check(IsInRenderingThread());
+
+	SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+
+	FTexture2DRHIRef RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
+
+	FShaderTestFrameGraph::AddPasses(RHICmdList,
+		[CompiledCameraModel, Mode, bUseDisplacementMap, InputTextureReference, RenderTargetTexture, FeatureLevel](FRDGBuilder& GraphBuilder)
+	{
+		SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+		SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, LensDistortion);
+
+		FRHITexture* InputTextureRHI = InputTextureReference->GetReferencedTexture();
+		if (!InputTextureRHI || !InputTextureRHI->GetTexture2D())
+		{
+			UE_LOG(LogTemp, Error, TEXT("FFooCameraModel::ApplyToRenderTarget, the input texture is not a 2D texture"));
+			return;
+		}
+
+		FRDGTextureRef InputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(InputTextureRHI, TEXT("LensDistortionApplyInput")));
+		FRDGTextureRef OutputTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("LensDistortionApplyOutput")));
+		GraphBuilder.SetTextureAccessFinal(OutputTexture, ERHIAccess::SRVMask);
+
+		AddLensDistortionApplyPass(GraphBuilder, FeatureLevel, CompiledCameraModel, Mode,
+			InputTexture, FIntRect(FIntPoint::ZeroValue, InputTexture->Desc.Extent),
+			OutputTexture, FIntRect(FIntPoint::ZeroValue, OutputTexture->Desc.Extent),
+			bUseDisplacementMap);
+	});
 }
 
 
@@ -243,7 +889,7 @@ FVector2D FFooCameraModel::UndistortNormalizedViewPosition(FVector2D EngineV) co
 
 /** Compiles the camera model. */
 float FFooCameraModel::GetUndistortOverscanFactor(
-	float DistortedHorizontalFOV, float DistortedAspectRatio) const
+	float DistortedHorizontalFOV, float DistortedAspectRatio, bool bPrecise) const
 {
 	// If the lens distortion model is identity, then early return 1.
 	if (*this == FFooCameraModel())
@@ -251,6 +897,11 @@ float FFooCameraModel::GetUndistortOverscanFactor(
 		return 1.0f;
 	}
 
+	if (bPrecise)
+	{
+		return GetPreciseUndistortOverscanFactor(*this, DistortedHorizontalFOV, DistortedAspectRatio);
+	}
+
 	float TanHalfDistortedHorizontalFOV = FMath::Tan(DistortedHorizontalFOV * 0.5f);
 
 	// Get the position in the view space at z'=1 of different key point in the distorted Viewport UV coordinate system.
@@ -310,44 +961,113 @@ float FFooCameraModel::GetUndistortOverscanFactor(
 }
 
 
-void FFooCameraModel::DrawUVDisplacementToRenderTarget(
-	UWorld* World,
+FCompiledCameraModel FCompiledCameraModel::Compile(
+	const FFooCameraModel& CameraModel,
 	float DistortedHorizontalFOV,
 	float DistortedAspectRatio,
 	float UndistortOverscanFactor,
-	UTextureRenderTarget2D* OutputRenderTarget,
 	float OutputMultiply,
-	float OutputAdd) const
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection)
 {
-	check(IsInGameThread());
-
-	if (!OutputRenderTarget)
-	{
-		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_OutputTargetRequired", "DrawUVDisplacementToRenderTarget: Output render target is required."));
-		return;
-	}
-
 	// Compiles the camera model to know the overscan scale factor.
 	float TanHalfUndistortedHorizontalFOV = FMath::Tan(DistortedHorizontalFOV * 0.5f) * UndistortOverscanFactor;
 	float TanHalfUndistortedVerticalFOV = TanHalfUndistortedHorizontalFOV / DistortedAspectRatio;
 
 	// Output.
 	FCompiledCameraModel CompiledCameraModel;
-	CompiledCameraModel.OriginalCameraModel = *this;
+	CompiledCameraModel.OriginalCameraModel = CameraModel;
 
 	CompiledCameraModel.DistortedCameraMatrix.X = 1.0f / TanHalfUndistortedHorizontalFOV;
 	CompiledCameraModel.DistortedCameraMatrix.Y = 1.0f / TanHalfUndistortedVerticalFOV;
 	CompiledCameraModel.DistortedCameraMatrix.Z = 0.5f;
 	CompiledCameraModel.DistortedCameraMatrix.W = 0.5f;
 
-	CompiledCameraModel.UndistortedCameraMatrix.X = F.X;
-	CompiledCameraModel.UndistortedCameraMatrix.Y = F.Y * DistortedAspectRatio;
-	CompiledCameraModel.UndistortedCameraMatrix.Z = C.X;
-	CompiledCameraModel.UndistortedCameraMatrix.W = C.Y;
+	CompiledCameraModel.UndistortedCameraMatrix.X = CameraModel.F.X;
+	CompiledCameraModel.UndistortedCameraMatrix.Y = CameraModel.F.Y * DistortedAspectRatio;
+	CompiledCameraModel.UndistortedCameraMatrix.Z = CameraModel.C.X;
+	CompiledCameraModel.UndistortedCameraMatrix.W = CameraModel.C.Y;
 
 	CompiledCameraModel.OutputMultiplyAndAdd.X = OutputMultiply;
 	CompiledCameraModel.OutputMultiplyAndAdd.Y = OutputAdd;
 
+	CompiledCameraModel.SingleDirection = SingleDirection;
+
+	return CompiledCameraModel;
+}
+
+
+FCompiledCameraModel FCompiledCameraModel::CompileForFormat(
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	EPixelFormat Format,
+	float OutputMultiply,
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection)
+{
+	if (OutputMultiply <= 0.0f && IsUVDisplacementNormalizedFormat(Format))
+	{
+		CameraModel.GetNormalizedUVDisplacementMultiplyAndAdd(
+			DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputMultiply, OutputAdd);
+	}
+
+	return Compile(CameraModel, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputMultiply, OutputAdd, SingleDirection);
+}
+
+
+float FCompiledCameraModel::GetMaxParameterDifference(const FCompiledCameraModel& Other) const
+{
+	if (SingleDirection != Other.SingleDirection)
+	{
+		return MAX_flt;
+	}
+
+	const FFooCameraModel& A = OriginalCameraModel;
+	const FFooCameraModel& B = Other.OriginalCameraModel;
+
+	const double Differences[] = {
+		FMath::Abs(A.K1 - B.K1), FMath::Abs(A.K2 - B.K2), FMath::Abs(A.K3 - B.K3), FMath::Abs(A.P1 - B.P1), FMath::Abs(A.P2 - B.P2),
+		FMath::Abs(DistortedCameraMatrix.X - Other.DistortedCameraMatrix.X), FMath::Abs(DistortedCameraMatrix.Y - Other.DistortedCameraMatrix.Y),
+		FMath::Abs(DistortedCameraMatrix.Z - Other.DistortedCameraMatrix.Z), FMath::Abs(DistortedCameraMatrix.W - Other.DistortedCameraMatrix.W),
+		FMath::Abs(UndistortedCameraMatrix.X - Other.UndistortedCameraMatrix.X), FMath::Abs(UndistortedCameraMatrix.Y - Other.UndistortedCameraMatrix.Y),
+		FMath::Abs(UndistortedCameraMatrix.Z - Other.UndistortedCameraMatrix.Z), FMath::Abs(UndistortedCameraMatrix.W - Other.UndistortedCameraMatrix.W),
+		FMath::Abs(OutputMultiplyAndAdd.X - Other.OutputMultiplyAndAdd.X), FMath::Abs(OutputMultiplyAndAdd.Y - Other.OutputMultiplyAndAdd.Y),
+	};
+
+	double MaxDifference = 0.0;
+	for (double Difference : Differences)
+	{
+		MaxDifference = FMath::Max(MaxDifference, Difference);
+	}
+	return float(MaxDifference);
+}
+
+
+void FFooCameraModel::DrawUVDisplacementToRenderTarget(
+	UWorld* World,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	UTextureRenderTarget2D* OutputRenderTarget,
+	float OutputMultiply,
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection) const
+{
+	check(IsInGameThread());
+
+	if (!OutputRenderTarget)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_OutputTargetRequired", "DrawUVDisplacementToRenderTarget: Output render target is required."));
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(LensDistortion, GameThread);
+
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::CompileForFormat(
+		*this, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputRenderTarget->GetFormat(), OutputMultiply, OutputAdd, SingleDirection);
+
 	const FName TextureRenderTargetName = OutputRenderTarget->GetFName();
 	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
 
@@ -371,5 +1091,174 @@ void FFooCameraModel::DrawUVDisplacementToRenderTarget(
 		}
 	);
 }
+
+
+void FFooCameraModel::DrawAnimatedUVDisplacementToRenderTarget(
+	UWorld* World,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	UTextureRenderTarget2D* OutputRenderTarget,
+	float OutputMultiply,
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection) const
+{
+	check(IsInGameThread());
+
+	if (!OutputRenderTarget)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_AnimatedOutputTargetRequired", "DrawAnimatedUVDisplacementToRenderTarget: Output render target is required."));
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(LensDistortion, GameThread);
+
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::CompileForFormat(
+		*this, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, OutputRenderTarget->GetFormat(), OutputMultiply, OutputAdd, SingleDirection);
+
+	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
+
+	ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();
+
+	if (FeatureLevel < ERHIFeatureLevel::SM5)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_AnimatedSM5Unavailable", "DrawAnimatedUVDisplacementToRenderTarget: Requires RHIFeatureLevel::SM5 which is unavailable."));
+		return;
+	}
+
+	ENQUEUE_RENDER_COMMAND(LensDistortionAnimatedDisplacement)(
+		[CompiledCameraModel, TextureRenderTargetResource, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+
+			FTexture2DRHIRef RenderTargetTexture = TextureRenderTargetResource->GetRenderTargetTexture();
+
+			FShaderTestFrameGraph::AddPasses(RHICmdList, [CompiledCameraModel, RenderTargetTexture, FeatureLevel](FRDGBuilder& GraphBuilder)
+			{
+				SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+				SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, LensDistortion);
+
+				GLensDistortionAnimatedDisplacement.AddDrawUVDisplacementPasses(GraphBuilder, FeatureLevel, CompiledCameraModel, RenderTargetTexture,
+					[&GraphBuilder, &CompiledCameraModel, FeatureLevel](FRDGTextureRef Texture)
+					{
+						AddUVDisplacementGridPass(GraphBuilder, FeatureLevel, CompiledCameraModel, Texture);
+					});
+			});
+		}
+	);
+}
+
+
+// static
+void FFooCameraModel::DrawUVDisplacementsToRenderTargetArray(
+	UWorld* World,
+	TConstArrayView<FLensDistortionCamera> Cameras,
+	UTextureRenderTarget2DArray* OutputRenderTarget,
+	float OutputMultiply,
+	float OutputAdd,
+	ELensDistortionApplyMode SingleDirection)
+{
+	check(IsInGameThread());
+
+	if (!OutputRenderTarget || Cameras.Num() == 0)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_ArrayOutputTargetRequired", "DrawUVDisplacementsToRenderTargetArray: Output render target array and cameras are required."));
+		return;
+	}
+
+	int32 NumCameras = Cameras.Num();
+	if (NumCameras > OutputRenderTarget->Slices)
+	{
+		FMessageLog("Blueprint").Warning(FText::Format(
+			LOCTEXT("LensDistortionCameraModel_ArrayTooFewSlices", "DrawUVDisplacementsToRenderTargetArray: Only the first {0} cameras fit in the slices of the output render target array."),
+			FText::AsNumber(OutputRenderTarget->Slices)));
+		NumCameras = OutputRenderTarget->Slices;
+	}
+
+	SHADERTEST_PASS_SCOPE(LensDistortion, GameThread);
+
+	const EPixelFormat Format = OutputRenderTarget->GetFormat();
+
+	TArray<FCompiledCameraModel> CompiledCameraModels;
+	CompiledCameraModels.Reserve(NumCameras);
+	for (int32 CameraIndex = 0; CameraIndex < NumCameras; CameraIndex++)
+	{
+		const FLensDistortionCamera& Camera = Cameras[CameraIndex];
+		CompiledCameraModels.Add(FCompiledCameraModel::CompileForFormat(
+			Camera.CameraModel, Camera.DistortedHorizontalFOV, Camera.DistortedAspectRatio, Camera.UndistortOverscanFactor,
+			Format, OutputMultiply, OutputAdd, SingleDirection));
+	}
+
+	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
+
+	ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();
+
+	if (FeatureLevel < ERHIFeatureLevel::SM5)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_ArraySM5Unavailable", "DrawUVDisplacementsToRenderTargetArray: Requires RHIFeatureLevel::SM5 which is unavailable."));
+		return;
+	}
+
+	ENQUEUE_RENDER_COMMAND(LensDistortionDisplacementArray)(
+		[CompiledCameraModels = MoveTemp(CompiledCameraModels), TextureRenderTargetResource, FeatureLevel](FRHICommandListImmediate& RHICmdList) mutable
+		{
+			DrawUVDisplacementsToRenderTargetArray_RenderThread(
+				RHICmdList,
+				MoveTemp(CompiledCameraModels),
+				TextureRenderTargetResource,
+				FeatureLevel);
+		}
+	);
+}
+
+
+void FFooCameraModel::ApplyToRenderTarget(
+	UWorld* World,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	UTexture* InputTexture,
+	UTextureRenderTarget2D* OutputRenderTarget,
+	ELensDistortionApplyMode Mode,
+	bool bUseDisplacementMap) const
+{
+	check(IsInGameThread());
+
+	if (!InputTexture || !OutputRenderTarget)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_ApplyTexturesRequired", "ApplyToRenderTarget: Input texture and output render target are required."));
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(LensDistortion, GameThread);
+
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::Compile(
+		*this, DistortedHorizontalFOV, DistortedAspectRatio, UndistortOverscanFactor, 1.0f, 0.0f);
+
+	FTextureReferenceRHIRef InputTextureReference = InputTexture->TextureReference.TextureReferenceRHI;
+	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
+
+	ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();
+
+	if (FeatureLevel < ERHIFeatureLevel::SM5)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("LensDistortionCameraModel_ApplySM5Unavailable", "ApplyToRenderTarget: Requires RHIFeatureLevel::SM5 which is unavailable."));
+		return;
+	}
+
+	ENQUEUE_RENDER_COMMAND(LensDistortionApply)(
+		[CompiledCameraModel, Mode, bUseDisplacementMap, InputTextureReference, TextureRenderTargetResource, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			ApplyToRenderTarget_RenderThread(
+				RHICmdList,
+				CompiledCameraModel,
+				Mode,
+				bUseDisplacementMap,
+				InputTextureReference,
+				TextureRenderTargetResource,
+				FeatureLevel);
+		}
+	);
+}
 PRAGMA_ENABLE_DEPRECATION_WARNINGS
 #undef LOCTEXT_NAMESPACE
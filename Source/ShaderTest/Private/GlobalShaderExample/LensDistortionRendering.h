@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphDefinitions.h"
+#include "GlobalShaderExample/LensDistortionAPI.h"
+
+
+/** Channels of a displacement map, picked from the pixel format of the render target by GetUVDisplacementEncoding(). */
+enum class ELensDistortionDisplacementEncoding : uint8
+{
+	/** Both directions: the distortion displacement in RG, the undistortion one in BA. */
+	RGBA,
+	/** The distortion displacement only in RG, for the two channel float formats. */
+	DistortRG,
+	/** The undistortion displacement only in RG, for the two channel float formats. */
+	UndistortRG,
+	/** Both directions as half floats packed in PF_R32G32_UINT: the distortion displacement in R, the undistortion one in G. */
+	PackedHalf,
+	MAX
+};
+
+
+/**
+ * Internal intermediary structure derived from FFooCameraModel by the game thread
+ * to hand to the render thread.
+ */
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
+struct FCompiledCameraModel
+{
+	/** Orignal camera model that has generated this compiled model. */
+	FFooCameraModel OriginalCameraModel;
+
+	/** Camera matrices of the lens distortion for the undistorted and distorted render.
+	 *  XY holds the scales factors, ZW holds the translates.
+	 */
+	FVector4 DistortedCameraMatrix;
+	FVector4 UndistortedCameraMatrix;
+
+	/** Output multiply and add of the channel to the render target. */
+	FVector2D OutputMultiplyAndAdd;
+
+	/** Direction kept by the two channel float formats, see GetUVDisplacementEncoding(). */
+	ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort;
+
+	/** Compiles the camera model for a given distorted render. */
+	static FCompiledCameraModel Compile(
+		const FFooCameraModel& CameraModel,
+		float DistortedHorizontalFOV,
+		float DistortedAspectRatio,
+		float UndistortOverscanFactor,
+		float OutputMultiply,
+		float OutputAdd,
+		ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort);
+
+	/** Compiles the camera model for a displacement map of that pixel format, the 8 bit normalized formats drawn
+	 *  with an OutputMultiply <= 0 get the output multiply and add fitting the displacements of the model.
+	 */
+	static FCompiledCameraModel CompileForFormat(
+		const FFooCameraModel& CameraModel,
+		float DistortedHorizontalFOV,
+		float DistortedAspectRatio,
+		float UndistortOverscanFactor,
+		EPixelFormat Format,
+		float OutputMultiply,
+		float OutputAdd,
+		ELensDistortionApplyMode SingleDirection);
+
+	/** Largest difference with another compiled model of the parameters sent to the shaders. */
+	float GetMaxParameterDifference(const FCompiledCameraModel& Other) const;
+};
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+
+/** Encoding of the displacement maps drawn into a texture of that format: PF_R32G32_UINT packs both directions,
+ *  PF_G16R16F and PF_G32R32F keep the single direction of the camera model, the other formats hold both in RGBA.
+ */
+ELensDistortionDisplacementEncoding GetUVDisplacementEncoding(EPixelFormat Format, ELensDistortionApplyMode SingleDirection);
+
+/** Whether the format has normalized 8 bit channels, which need an output multiply and add fitted to the displacements of the model. */
+bool IsUVDisplacementNormalizedFormat(EPixelFormat Format);
+
+/** Whether the compute passes can write the displacement maps of a texture of that format: the format needs typed UAV stores,
+ *  which are not guaranteed for the 8 bit formats, and the writes must be linear, the UAV of an sRGB texture does not encode them.
+ *  The other maps are drawn by the grid pass through a render target view.
+ */
+bool CanWriteUVDisplacementWithCompute(EPixelFormat Format, bool bSRGB);
+
+/** Whether the displacement maps of a texture of that format are generated by the compute pass, see r.ShaderTest.LensDistortion.UseCompute. */
+bool ShouldGenerateUVDisplacementWithCompute(EPixelFormat Format, bool bSRGB);
+
+
+/** Adds a compute pass drawing the UV displacement map of the compiled camera model into OutputTexture, which needs UAV support,
+ *  in the encoding of its pixel format.
+ *  Both directions are evaluated per texel, the distortion by Newton iterations, so there is no raster setup.
+ *  @param PassFlags ERDGPassFlags::AsyncCompute lets the pass overlap with the graphics work of the graph.
+ */
+void AddLensDistortionUVDisplacementPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FCompiledCameraModel& CompiledCameraModel,
+	FRDGTextureRef OutputTexture,
+	ERDGPassFlags PassFlags = ERDGPassFlags::Compute);
+
+
+/** Adds a single compute pass drawing the UV displacement maps of the compiled camera models into the slices of OutputTextureArray,
+ *  slice i for CompiledCameraModels[i], same evaluation as AddLensDistortionUVDisplacementPass(). The per camera parameters are
+ *  read from a structured buffer, so the cameras only cost one dispatch. OutputTextureArray needs UAV support and at least as
+ *  many slices as cameras, the encoding of its format is picked with the SingleDirection of the first camera.
+ */
+void AddLensDistortionUVDisplacementArrayPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	TConstArrayView<FCompiledCameraModel> CompiledCameraModels,
+	FRDGTextureRef OutputTextureArray,
+	ERDGPassFlags PassFlags = ERDGPassFlags::Compute);
+
+
+/** Adds a full screen pass warping InputViewRect of InputTexture into OutputViewRect of OutputTexture with the lens distortion
+ *  of the compiled camera model, sampling the input once per pixel instead of going through a displacement map.
+ *  The undistortion is evaluated per pixel, the distortion by Newton iterations.
+ *  @param bUseDisplacementMap Reads both from the cached displacement map of the output view size instead.
+ */
+void AddLensDistortionApplyPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FCompiledCameraModel& CompiledCameraModel,
+	ELensDistortionApplyMode Mode,
+	FRDGTextureRef InputTexture,
+	FIntRect InputViewRect,
+	FRDGTextureRef OutputTexture,
+	FIntRect OutputViewRect,
+	bool bUseDisplacementMap = false);
@@ -0,0 +1,145 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/VectorRegister.h"
+#include "GlobalShaderExample/LensDistortionAPI.h"
+
+
+/** Number of Newton iterations of the vectorized distort solve, the lens models we get converge in 3 to 5. */
+static constexpr int32 kLensDistortionNewtonIterations = 8;
+
+/** Residual in the view space (z=1) under which a distort solve is considered converged. */
+static constexpr float kLensDistortionNewtonTolerance = 1.e-5f;
+
+
+/** Camera model coefficients splatted into vector registers to evaluate 4 positions at a time (SoA). */
+struct FLensDistortionVectorModel
+{
+	VectorRegister4Float K1;
+	VectorRegister4Float K2;
+	VectorRegister4Float K3;
+	VectorRegister4Float P1;
+	VectorRegister4Float P2;
+
+	explicit FLensDistortionVectorModel(const FFooCameraModel& CameraModel)
+		: K1(VectorSetFloat1(CameraModel.K1))
+		, K2(VectorSetFloat1(CameraModel.K2))
+		, K3(VectorSetFloat1(CameraModel.K3))
+		, P1(VectorSetFloat1(CameraModel.P1))
+		, P2(VectorSetFloat1(CameraModel.P2))
+	{ }
+};
+
+
+/** Undistorts 4 view positions (x, y, z=1.f) in the standard view space, matches UndistortNormalizedViewPosition() of LensDistortion.ush. */
+FORCEINLINE void VectorUndistortNormalizedViewPosition(
+	const FLensDistortionVectorModel& Model,
+	const VectorRegister4Float& X, const VectorRegister4Float& Y,
+	VectorRegister4Float& OutX, VectorRegister4Float& OutY)
+{
+	const VectorRegister4Float Two = VectorSetFloat1(2.f);
+	const VectorRegister4Float X2 = VectorMultiply(X, X);
+	const VectorRegister4Float Y2 = VectorMultiply(Y, Y);
+	const VectorRegister4Float TwoXY = VectorMultiply(Two, VectorMultiply(X, Y));
+	const VectorRegister4Float R2 = VectorAdd(X2, Y2);
+
+	// Radial distortion: 1 + R2 * (K1 + R2 * (K2 + R2 * K3)).
+	const VectorRegister4Float Radial = VectorMultiplyAdd(R2,
+		VectorMultiplyAdd(R2, VectorMultiplyAdd(R2, Model.K3, Model.K2), Model.K1), GlobalVectorConstants::FloatOne);
+
+	// Tangential distortion.
+	OutX = VectorMultiplyAdd(X, Radial, VectorMultiplyAdd(Model.P2, VectorMultiplyAdd(Two, X2, R2), VectorMultiply(Model.P1, TwoXY)));
+	OutY = VectorMultiplyAdd(Y, Radial, VectorMultiplyAdd(Model.P1, VectorMultiplyAdd(Two, Y2, R2), VectorMultiply(Model.P2, TwoXY)));
+}
+
+
+/** Same as VectorUndistortNormalizedViewPosition(), also returning the Jacobian which is symmetric (dX/dy == dY/dx). */
+FORCEINLINE void VectorUndistortNormalizedViewPositionWithJacobian(
+	const FLensDistortionVectorModel& Model,
+	const VectorRegister4Float& X, const VectorRegister4Float& Y,
+	VectorRegister4Float& OutX, VectorRegister4Float& OutY,
+	VectorRegister4Float& OutDXdx, VectorRegister4Float& OutDXdy, VectorRegister4Float& OutDYdy)
+{
+	const VectorRegister4Float Two = VectorSetFloat1(2.f);
+	const VectorRegister4Float X2 = VectorMultiply(X, X);
+	const VectorRegister4Float Y2 = VectorMultiply(Y, Y);
+	const VectorRegister4Float TwoXY = VectorMultiply(Two, VectorMultiply(X, Y));
+	const VectorRegister4Float R2 = VectorAdd(X2, Y2);
+
+	const VectorRegister4Float Radial = VectorMultiplyAdd(R2,
+		VectorMultiplyAdd(R2, VectorMultiplyAdd(R2, Model.K3, Model.K2), Model.K1), GlobalVectorConstants::FloatOne);
+
+	// d(Radial)/d(R2) = K1 + 2 * K2 * R2 + 3 * K3 * R2^2.
+	const VectorRegister4Float RadialDerivative = VectorMultiplyAdd(R2,
+		VectorMultiplyAdd(R2, VectorMultiply(VectorSetFloat1(3.f), Model.K3), VectorMultiply(Two, Model.K2)), Model.K1);
+
+	OutX = VectorMultiplyAdd(X, Radial, VectorMultiplyAdd(Model.P2, VectorMultiplyAdd(Two, X2, R2), VectorMultiply(Model.P1, TwoXY)));
+	OutY = VectorMultiplyAdd(Y, Radial, VectorMultiplyAdd(Model.P1, VectorMultiplyAdd(Two, Y2, R2), VectorMultiply(Model.P2, TwoXY)));
+
+	// 2 * (P1 * x + P2 * y) shows up in every term of the Jacobian.
+	const VectorRegister4Float Tangential = VectorMultiply(Two, VectorMultiplyAdd(Model.P1, X, VectorMultiply(Model.P2, Y)));
+	const VectorRegister4Float Six = VectorSetFloat1(6.f);
+
+	OutDXdx = VectorAdd(
+		VectorMultiplyAdd(VectorMultiply(Two, X2), RadialDerivative, Radial),
+		VectorMultiplyAdd(VectorMultiply(Six, Model.P2), X, VectorMultiply(VectorMultiply(Two, Model.P1), Y)));
+	OutDXdy = VectorMultiplyAdd(TwoXY, RadialDerivative, Tangential);
+	OutDYdy = VectorAdd(
+		VectorMultiplyAdd(VectorMultiply(Two, Y2), RadialDerivative, Radial),
+		VectorMultiplyAdd(VectorMultiply(Six, Model.P1), Y, VectorMultiply(VectorMultiply(Two, Model.P2), X)));
+}
+
+
+/** Distorts 4 view positions (x', y', z'=1.f) by solving VectorUndistortNormalizedViewPosition(V) = Target
+ * with a fixed budget of Newton iterations, starting from V = Target.
+ * @return Mask bits of the lanes that converged under kLensDistortionNewtonTolerance.
+ */
+FORCEINLINE int32 VectorDistortNormalizedViewPosition(
+	const FLensDistortionVectorModel& Model,
+	const VectorRegister4Float& TargetX, const VectorRegister4Float& TargetY,
+	VectorRegister4Float& OutX, VectorRegister4Float& OutY,
+	int32 NumIterations = kLensDistortionNewtonIterations)
+{
+	const VectorRegister4Float MinDeterminant = VectorSetFloat1(1.e-8f);
+
+	VectorRegister4Float X = TargetX;
+	VectorRegister4Float Y = TargetY;
+	VectorRegister4Float ResidualX = GlobalVectorConstants::FloatZero;
+	VectorRegister4Float ResidualY = GlobalVectorConstants::FloatZero;
+
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+	{
+		VectorRegister4Float UndistortedX, UndistortedY, DXdx, DXdy, DYdy;
+		VectorUndistortNormalizedViewPositionWithJacobian(Model, X, Y, UndistortedX, UndistortedY, DXdx, DXdy, DYdy);
+
+		ResidualX = VectorSubtract(TargetX, UndistortedX);
+		ResidualY = VectorSubtract(TargetY, UndistortedY);
+
+		// Solve the 2x2 symmetric system J * Step = Residual, lanes with a singular Jacobian don't move.
+		const VectorRegister4Float Determinant = VectorSubtract(VectorMultiply(DXdx, DYdy), VectorMultiply(DXdy, DXdy));
+		const VectorRegister4Float IsSolvable = VectorCompareGT(VectorAbs(Determinant), MinDeterminant);
+		const VectorRegister4Float InvDeterminant = VectorSelect(IsSolvable, VectorDivide(GlobalVectorConstants::FloatOne, Determinant), GlobalVectorConstants::FloatZero);
+
+		const VectorRegister4Float StepX = VectorMultiply(InvDeterminant, VectorSubtract(VectorMultiply(DYdy, ResidualX), VectorMultiply(DXdy, ResidualY)));
+		const VectorRegister4Float StepY = VectorMultiply(InvDeterminant, VectorSubtract(VectorMultiply(DXdx, ResidualY), VectorMultiply(DXdy, ResidualX)));
+
+		X = VectorAdd(X, StepX);
+		Y = VectorAdd(Y, StepY);
+	}
+
+	// Residual of the final position.
+	{
+		VectorRegister4Float UndistortedX, UndistortedY;
+		VectorUndistortNormalizedViewPosition(Model, X, Y, UndistortedX, UndistortedY);
+		ResidualX = VectorSubtract(TargetX, UndistortedX);
+		ResidualY = VectorSubtract(TargetY, UndistortedY);
+	}
+
+	OutX = X;
+	OutY = Y;
+
+	const VectorRegister4Float Residual = VectorAdd(VectorAbs(ResidualX), VectorAbs(ResidualY));
+	return VectorMaskBits(VectorCompareLT(Residual, VectorSetFloat1(kLensDistortionNewtonTolerance)));
+}
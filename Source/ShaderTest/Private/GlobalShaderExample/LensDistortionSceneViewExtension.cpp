@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LensDistortionSceneViewExtension.h"
+#include "LensDistortionRendering.h"
+#include "Common/ShaderTestPassProfiler.h"
+
+#include "PostProcess/PostProcessMaterial.h"
+#include "ScreenPass.h"
+#include "SceneView.h"
+
+
+/** Game thread, held until the module shuts down. */
+static TSharedPtr<FLensDistortionSceneViewExtension, ESPMode::ThreadSafe> GLensDistortionSceneViewExtension;
+
+
+FLensDistortionSceneViewExtension::FLensDistortionSceneViewExtension(const FAutoRegister& AutoRegister)
+	: FSceneViewExtensionBase(AutoRegister)
+{ }
+
+
+// static
+void FLensDistortionSceneViewExtension::Enable(const FLensDistortionPostProcessSettings& Settings)
+{
+	check(IsInGameThread());
+
+	if (!GLensDistortionSceneViewExtension.IsValid())
+	{
+		GLensDistortionSceneViewExtension = FSceneViewExtensions::NewExtension<FLensDistortionSceneViewExtension>();
+	}
+
+	FLensDistortionSceneViewExtension* Extension = GLensDistortionSceneViewExtension.Get();
+	Extension->bEnabled = true;
+
+	ENQUEUE_RENDER_COMMAND(LensDistortionPostProcessSettings)(
+		[Extension, Settings](FRHICommandListImmediate& RHICmdList)
+		{
+			Extension->Settings_RenderThread = Settings;
+		});
+}
+
+
+// static
+void FLensDistortionSceneViewExtension::Disable()
+{
+	check(IsInGameThread());
+
+	if (GLensDistortionSceneViewExtension.IsValid())
+	{
+		GLensDistortionSceneViewExtension->bEnabled = false;
+	}
+}
+
+
+// static
+void FLensDistortionSceneViewExtension::Shutdown()
+{
+	// The render commands of Enable() reference the extension.
+	if (GLensDistortionSceneViewExtension.IsValid())
+	{
+		FlushRenderingCommands();
+		GLensDistortionSceneViewExtension.Reset();
+	}
+}
+
+
+bool FLensDistortionSceneViewExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
+{
+	return bEnabled;
+}
+
+
+void FLensDistortionSceneViewExtension::SubscribeToPostProcessingPass(EPostProcessingPass PassId, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled)
+{
+	if (PassId == EPostProcessingPass::Tonemap)
+	{
+		InOutPassCallbacks.Add(FAfterPassCallbackDelegate::CreateRaw(this, &FLensDistortionSceneViewExtension::PostProcessPassAfterTonemap_RenderThread));
+	}
+}
+
+
+FScreenPassTexture FLensDistortionSceneViewExtension::PostProcessPassAfterTonemap_RenderThread(
+	FRDGBuilder& GraphBuilder,
+	const FSceneView& View,
+	const FPostProcessMaterialInputs& Inputs)
+{
+	const FScreenPassTexture SceneColor = Inputs.GetInput(EPostProcessMaterialInput::SceneColor);
+
+	if (!SceneColor.IsValid() || !View.IsPerspectiveProjection() || View.GetFeatureLevel() < ERHIFeatureLevel::SM5)
+	{
+		return SceneColor;
+	}
+
+	SHADERTEST_PASS_SCOPE(LensDistortion, RenderThread);
+	SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, LensDistortion);
+
+	const FLensDistortionPostProcessSettings& Settings = Settings_RenderThread;
+
+	// The view is rendered undistorted and overscanned to be distorted, distorted to be undistorted.
+	const float TanHalfHorizontalFOV = 1.0f / View.ViewMatrices.GetProjectionMatrix().M[0][0];
+	const float TanHalfDistortedHorizontalFOV = Settings.Mode == ELensDistortionApplyMode::Distort
+		? TanHalfHorizontalFOV / Settings.UndistortOverscanFactor
+		: TanHalfHorizontalFOV;
+	const float DistortedAspectRatio = float(SceneColor.ViewRect.Width()) / float(SceneColor.ViewRect.Height());
+
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::Compile(
+		Settings.CameraModel, 2.0f * FMath::Atan(TanHalfDistortedHorizontalFOV), DistortedAspectRatio, Settings.UndistortOverscanFactor, 1.0f, 0.0f);
+
+	FScreenPassRenderTarget Output = Inputs.OverrideOutput;
+	if (!Output.IsValid())
+	{
+		Output = FScreenPassRenderTarget::CreateFromInput(GraphBuilder, SceneColor, View.GetOverwriteLoadAction(), TEXT("LensDistortionApply"));
+	}
+
+	AddLensDistortionApplyPass(GraphBuilder, View.GetFeatureLevel(), CompiledCameraModel, Settings.Mode,
+		SceneColor.Texture, SceneColor.ViewRect, Output.Texture, Output.ViewRect, Settings.bUseDisplacementMap);
+
+	return MoveTemp(Output);
+}
@@ -0,0 +1,66 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SceneViewExtension.h"
+#include "GlobalShaderExample/LensDistortionAPI.h"
+
+
+/** Lens distortion applied to the views by FLensDistortionSceneViewExtension. */
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
+struct FLensDistortionPostProcessSettings
+{
+	FFooCameraModel CameraModel;
+
+	/** Overscan of the undistorted render: the views are rendered overscanned for Distort, the output is for Undistort. */
+	float UndistortOverscanFactor = 1.0f;
+
+	ELensDistortionApplyMode Mode = ELensDistortionApplyMode::Distort;
+
+	/** Reads the warp from the cached displacement map of the view size, see AddLensDistortionApplyPass(). */
+	bool bUseDisplacementMap = false;
+};
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+
+/**
+ * Warps the scene color of every perspective view after the tonemapper with AddLensDistortionApplyPass(),
+ * so no displacement map render target or post process material is needed.
+ *
+ * The camera model is compiled per view from its projection and view rect.
+ */
+class FLensDistortionSceneViewExtension : public FSceneViewExtensionBase
+{
+public:
+	FLensDistortionSceneViewExtension(const FAutoRegister& AutoRegister);
+
+	/** Game thread. Applies the lens distortion to the views rendered from now on, registering the extension on first use. */
+	static void Enable(const FLensDistortionPostProcessSettings& Settings);
+
+	/** Game thread. Stops applying the lens distortion. */
+	static void Disable();
+
+	/** Unregisters the extension, called by the module. */
+	static void Shutdown();
+
+	// ISceneViewExtension interface.
+	virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override { }
+	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override { }
+	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override { }
+	virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override { }
+	virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override { }
+	virtual void SubscribeToPostProcessingPass(EPostProcessingPass PassId, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled) override;
+
+protected:
+	virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
+
+private:
+	FScreenPassTexture PostProcessPassAfterTonemap_RenderThread(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessMaterialInputs& Inputs);
+
+	/** Game thread. */
+	bool bEnabled = false;
+
+	/** Render thread, updated by a render command from Enable(). */
+	FLensDistortionPostProcessSettings Settings_RenderThread;
+};
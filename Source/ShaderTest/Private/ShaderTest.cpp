@@ -2,6 +2,11 @@
 
 #include "ShaderTest.h"
 #include "Interfaces/IPluginManager.h"
+#include "Common/ShaderTestFrameGraph.h"
+#include "Common/ShaderTestPassProfiler.h"
+#include "Common/ShaderTestPSOPrecache.h"
+#include "Common/ShaderTestReadback.h"
+#include "GlobalShaderExample/LensDistortionSceneViewExtension.h"
 
 #define LOCTEXT_NAMESPACE "FShaderTestModule"
 
@@ -10,12 +15,21 @@ void FShaderTestModule::StartupModule()
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 	FString PluginShaderDir = FPaths::Combine(IPluginManager::Get().FindPlugin(TEXT("ShaderTest"))->GetBaseDir(), TEXT("Shaders"));
 	AddShaderSourceDirectoryMapping(TEXT("/Plugin/ShaderTest"), PluginShaderDir);
+
+	FShaderTestFrameGraph::Startup();
+	FShaderTestPassProfiler::Startup();
+	FShaderTestPSOPrecache::Startup();
 }
 
 void FShaderTestModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FLensDistortionSceneViewExtension::Shutdown();
+	FShaderTestPSOPrecache::Shutdown();
+	FShaderTestReadback::Shutdown();
+	FShaderTestPassProfiler::Shutdown();
+	FShaderTestFrameGraph::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,515 @@
+#include "Tests/ShaderTestReferences.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ShaderTestLibrary.h"
+#include "Common/ShaderTestFrameGraph.h"
+#include "ComputerShader/MyComputeShaderCPU.h"
+#include "GlobalShaderExample/LensDistortionCPU.h"
+#include "Engine/Engine.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "ImageCore.h"
+#include "Misc/App.h"
+#include "UObject/StrongObjectPtr.h"
+
+/**
+ * Each shader's CPU reference is checked against golden data, then against the GPU readback when the tests run with
+ * an SM5 RHI and a world (e.g. -vulkan with a software ICD on the CI agents). Under -nullrhi the GPU part is skipped.
+ */
+
+/** Golden pixel of a reference, computed offline in float. */
+struct FShaderTestGoldenPixel
+{
+	FIntPoint PixelPos;
+	FLinearColor Color;
+};
+
+
+/** A world whose scene can draw the plugin shaders, null without an SM5 RHI. */
+static UWorld* FindGPUTestWorld()
+{
+	if (!FApp::CanEverRender() || GUsingNullRHI || !GEngine)
+	{
+		return nullptr;
+	}
+
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		UWorld* World = Context.World();
+		if (World && World->Scene && World->Scene->GetFeatureLevel() >= ERHIFeatureLevel::SM5)
+		{
+			return World;
+		}
+	}
+	return nullptr;
+}
+
+
+static TStrongObjectPtr<UTextureRenderTarget2D> CreateTestRenderTarget(FIntPoint Resolution, bool bCanCreateUAV, ETextureRenderTargetFormat Format = RTF_RGBA32f)
+{
+	TStrongObjectPtr<UTextureRenderTarget2D> RenderTarget(NewObject<UTextureRenderTarget2D>(GetTransientPackage()));
+	RenderTarget->RenderTargetFormat = Format;
+	RenderTarget->ClearColor = FLinearColor::Black;
+	RenderTarget->bCanCreateUAV = bCanCreateUAV;
+	RenderTarget->InitAutoFormat(Resolution.X, Resolution.Y);
+	RenderTarget->UpdateResourceImmediate(true);
+	return RenderTarget;
+}
+
+
+/** Overrides an integer cvar of the plugin for the scope of a test case, the previous value is restored on exit. */
+class FScopedTestCVarOverride
+{
+public:
+	FScopedTestCVarOverride(const TCHAR* Name, int32 Value)
+		: CVar(IConsoleManager::Get().FindConsoleVariable(Name))
+	{
+		if (CVar)
+		{
+			PreviousValue = CVar->GetInt();
+			CVar->Set(Value, ECVF_SetByCode);
+		}
+	}
+
+	~FScopedTestCVarOverride()
+	{
+		if (CVar)
+		{
+			CVar->Set(PreviousValue, ECVF_SetByCode);
+		}
+	}
+
+private:
+	IConsoleVariable* CVar;
+	int32 PreviousValue = 0;
+};
+
+
+/** Blocking readback of the draws called before, only meant for the tests. */
+static bool ReadbackTestRenderTarget(UTextureRenderTarget2D* RenderTarget, TArray<FLinearColor>& OutPixels)
+{
+	// The draws may still be queued in the frame graph.
+	FShaderTestFrameGraph::EnqueueFlush();
+
+	FTextureRenderTargetResource* RenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
+	return RenderTargetResource && RenderTargetResource->ReadLinearColorPixels(OutPixels);
+}
+
+
+static float GetMaxChannelError(const FLinearColor& A, const FLinearColor& B)
+{
+	return FMath::Max(FMath::Max(FMath::Abs(A.R - B.R), FMath::Abs(A.G - B.G)), FMath::Max(FMath::Abs(A.B - B.B), FMath::Abs(A.A - B.A)));
+}
+
+
+static void TestGoldenPixels(
+	FAutomationTestBase& Test,
+	const TCHAR* What,
+	TConstArrayView<FLinearColor> Pixels,
+	FIntPoint Resolution,
+	TConstArrayView<FShaderTestGoldenPixel> GoldenPixels,
+	float Tolerance)
+{
+	for (const FShaderTestGoldenPixel& Golden : GoldenPixels)
+	{
+		const FLinearColor& Color = Pixels[Golden.PixelPos.Y * Resolution.X + Golden.PixelPos.X];
+		if (GetMaxChannelError(Color, Golden.Color) > Tolerance)
+		{
+			Test.AddError(FString::Printf(TEXT("%s: pixel (%d, %d) is %s, golden %s"),
+				What, Golden.PixelPos.X, Golden.PixelPos.Y, *Color.ToString(), *Golden.Color.ToString()));
+		}
+	}
+}
+
+
+/** Diffs a GPU readback against its CPU reference.
+ * @param MaxFractionAboveTolerance Fraction of the pixels allowed above the tolerance, for the chaotic shaders.
+ */
+static void TestReadbackAgainstReference(
+	FAutomationTestBase& Test,
+	const TCHAR* What,
+	TConstArrayView<FLinearColor> Readback,
+	TConstArrayView<FLinearColor> Reference,
+	float Tolerance,
+	float MaxFractionAboveTolerance = 0.f)
+{
+	if (Readback.Num() != Reference.Num())
+	{
+		Test.AddError(FString::Printf(TEXT("%s: read back %d pixels, expected %d"), What, Readback.Num(), Reference.Num()));
+		return;
+	}
+
+	float MaxError = 0.f;
+	int32 NumPixelsAboveTolerance = 0;
+	for (int32 Index = 0; Index < Reference.Num(); Index++)
+	{
+		const float Error = GetMaxChannelError(Readback[Index], Reference[Index]);
+		MaxError = FMath::Max(MaxError, Error);
+		NumPixelsAboveTolerance += Error > Tolerance ? 1 : 0;
+	}
+
+	Test.AddInfo(FString::Printf(TEXT("%s: %d/%d pixels above %f, max error %f"), What, NumPixelsAboveTolerance, Reference.Num(), Tolerance, MaxError));
+
+	if (NumPixelsAboveTolerance > int32(MaxFractionAboveTolerance * Reference.Num()))
+	{
+		Test.AddError(FString::Printf(TEXT("%s: %d pixels differ from the CPU reference by more than %f"), What, NumPixelsAboveTolerance, Tolerance));
+	}
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShaderTestFirstShaderReferenceTest, "Plugins.ShaderTest.References.FirstShader", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShaderTestFirstShaderReferenceTest::RunTest(const FString& Parameters)
+{
+	const FIntPoint Resolution(32, 16);
+	const FLinearColor Color(0.25f, 0.5f, 0.75f, 1.f);
+
+	TArray<FLinearColor> Reference;
+	DrawFirstShader_CPU(Color, Resolution, Reference);
+
+	const FShaderTestGoldenPixel GoldenPixels[] =
+	{
+		{ FIntPoint(0, 0), Color },
+		{ FIntPoint(31, 15), Color },
+		{ FIntPoint(17, 9), Color },
+	};
+	TestEqual(TEXT("Reference size"), Reference.Num(), Resolution.X * Resolution.Y);
+	TestGoldenPixels(*this, TEXT("FirstShader golden"), Reference, Resolution, GoldenPixels, 0.f);
+
+	UWorld* World = FindGPUTestWorld();
+	if (!World)
+	{
+		AddInfo(TEXT("No SM5 RHI, skipping the GPU readback."));
+		return true;
+	}
+
+	for (bool bUsingRDG : { false, true })
+	{
+		TStrongObjectPtr<UTextureRenderTarget2D> RenderTarget = CreateTestRenderTarget(Resolution, false);
+		UShaderTestLibrary::FirstShaderDrawRenderTarget(World, RenderTarget.Get(), Color, bUsingRDG);
+
+		TArray<FLinearColor> Readback;
+		if (!ReadbackTestRenderTarget(RenderTarget.Get(), Readback))
+		{
+			AddError(TEXT("FirstShader: failed to read the render target back"));
+			continue;
+		}
+		TestReadbackAgainstReference(*this, bUsingRDG ? TEXT("FirstShader RDG") : TEXT("FirstShader"), Readback, Reference, 1.e-5f);
+	}
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShaderTestTextureShaderReferenceTest, "Plugins.ShaderTest.References.TextureShader", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShaderTestTextureShaderReferenceTest::RunTest(const FString& Parameters)
+{
+	const FIntPoint Resolution(16, 8);
+
+	// Gradient texture with a distinct value per texel, to catch a missing or doubled flip.
+	TArray<FLinearColor> Texture;
+	Texture.SetNumUninitialized(Resolution.X * Resolution.Y);
+	for (int32 Y = 0; Y < Resolution.Y; Y++)
+	{
+		for (int32 X = 0; X < Resolution.X; X++)
+		{
+			Texture[Y * Resolution.X + X] = FLinearColor(float(X) / Resolution.X, float(Y) / Resolution.Y, 0.5f, 0.f);
+		}
+	}
+
+	FTestTextureShaderStructData TintData;
+	TintData.ColorOne = FLinearColor(1.f, 0.f, 0.f, 1.f);
+	TintData.ColorTwo = FLinearColor(0.5f, 1.f, 0.25f, 0.5f);
+	TintData.ColorThree = FLinearColor(0.f, 0.f, 1.f, 1.f);
+	TintData.ColorFour = FLinearColor(1.f, 1.f, 1.f, 1.f);
+	TintData.ColorIndex = 1;
+
+	FTestTextureShaderStructData UntintedData = TintData;
+	UntintedData.ColorIndex = 4;
+
+	FTestTextureShaderStructData SRGBData = TintData;
+	SRGBData.bOutputSRGB = true;
+
+	// Golden data, texel (X, Resolution.Y - 1 - Y) of the gradient.
+	{
+		TArray<FLinearColor> Reference;
+
+		DrawTestTextureShader_CPU(Texture, Resolution, TintData, Reference);
+		const FShaderTestGoldenPixel TintGoldenPixels[] =
+		{
+			{ FIntPoint(0, 0), FLinearColor(0.f, 0.875f, 0.125f, 0.5f) },
+			{ FIntPoint(8, 6), FLinearColor(0.25f, 0.125f, 0.125f, 0.5f) },
+			{ FIntPoint(15, 7), FLinearColor(0.46875f, 0.f, 0.125f, 0.5f) },
+		};
+		TestGoldenPixels(*this, TEXT("TextureShader tint golden"), Reference, Resolution, TintGoldenPixels, 1.e-6f);
+
+		DrawTestTextureShader_CPU(Texture, Resolution, UntintedData, Reference);
+		const FShaderTestGoldenPixel UntintedGoldenPixels[] =
+		{
+			{ FIntPoint(4, 0), FLinearColor(0.25f, 0.875f, 0.5f, 1.f) },
+			{ FIntPoint(12, 3), FLinearColor(0.75f, 0.5f, 0.5f, 1.f) },
+		};
+		TestGoldenPixels(*this, TEXT("TextureShader untinted golden"), Reference, Resolution, UntintedGoldenPixels, 1.e-6f);
+
+		DrawTestTextureShader_CPU(Texture, Resolution, SRGBData, Reference);
+		const FShaderTestGoldenPixel SRGBGoldenPixels[] =
+		{
+			{ FIntPoint(0, 7), FLinearColor(0.000789f, 0.000789f, 0.388573f, 0.5f) },
+			{ FIntPoint(8, 3), FLinearColor(0.537099f, 0.735357f, 0.388573f, 0.5f) },
+		};
+		TestGoldenPixels(*this, TEXT("TextureShader sRGB golden"), Reference, Resolution, SRGBGoldenPixels, 1.e-5f);
+	}
+
+	UWorld* World = FindGPUTestWorld();
+	if (!World)
+	{
+		AddInfo(TEXT("No SM5 RHI, skipping the GPU readback."));
+		return true;
+	}
+
+	TStrongObjectPtr<UTexture2D> SourceTexture(UTexture2D::CreateTransient(Resolution.X, Resolution.Y, PF_A32B32G32R32F));
+	SourceTexture->SRGB = false;
+	SourceTexture->Filter = TF_Nearest;
+	{
+		FTexture2DMipMap& Mip = SourceTexture->GetPlatformData()->Mips[0];
+		FMemory::Memcpy(Mip.BulkData.Lock(LOCK_READ_WRITE), Texture.GetData(), Texture.Num() * sizeof(FLinearColor));
+		Mip.BulkData.Unlock();
+	}
+	SourceTexture->UpdateResource();
+
+	// TextureReferenceRHI is updated by the render thread.
+	FlushRenderingCommands();
+
+	const TPair<const TCHAR*, const FTestTextureShaderStructData*> Cases[] =
+	{
+		{ TEXT("TextureShader tint"), &TintData },
+		{ TEXT("TextureShader untinted"), &UntintedData },
+		{ TEXT("TextureShader sRGB"), &SRGBData },
+	};
+
+	for (const TPair<const TCHAR*, const FTestTextureShaderStructData*>& Case : Cases)
+	{
+		TArray<FLinearColor> Reference;
+		DrawTestTextureShader_CPU(Texture, Resolution, *Case.Value, Reference);
+
+		TStrongObjectPtr<UTextureRenderTarget2D> RenderTarget = CreateTestRenderTarget(Resolution, false);
+		UShaderTestLibrary::DrawTestTextureShaderRenderTarget(World->GetWorldSettings(), RenderTarget.Get(), *Case.Value, SourceTexture.Get());
+
+		TArray<FLinearColor> Readback;
+		if (!ReadbackTestRenderTarget(RenderTarget.Get(), Readback))
+		{
+			AddError(FString::Printf(TEXT("%s: failed to read the render target back"), Case.Key));
+			continue;
+		}
+		TestReadbackAgainstReference(*this, Case.Key, Readback, Reference, 1.e-3f);
+	}
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShaderTestLensDistortionReferenceTest, "Plugins.ShaderTest.References.LensDistortion", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShaderTestLensDistortionReferenceTest::RunTest(const FString& Parameters)
+{
+	const FIntPoint Resolution(64, 36);
+	const float HorizontalFOV = HALF_PI;
+	const float AspectRatio = float(Resolution.X) / float(Resolution.Y);
+	const float OutputMultiply = 0.5f;
+	const float OutputAdd = 0.5f;
+
+	FFooCameraModel CameraModel;
+	CameraModel.K1 = -0.15f;
+	CameraModel.K2 = 0.03f;
+	CameraModel.P1 = 0.002f;
+	CameraModel.P2 = -0.001f;
+	CameraModel.F = FVector2D(0.6f, 0.6f);
+
+	PRAGMA_DISABLE_DEPRECATION_WARNINGS
+	const FCompiledCameraModel CompiledCameraModel = FCompiledCameraModel::Compile(CameraModel, HorizontalFOV, AspectRatio, 1.f, OutputMultiply, OutputAdd);
+	PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+	TArray<FLinearColor> Reference;
+	DrawUVDisplacementToBuffer_CPU(CompiledCameraModel, Resolution, Reference);
+
+	// Golden data, solved in double to convergence.
+	const FShaderTestGoldenPixel GoldenPixels[] =
+	{
+		{ FIntPoint(0, 0), FLinearColor(0.606837f, 0.607287f, 0.266326f, 0.263054f) },
+		{ FIntPoint(10, 5), FLinearColor(0.571103f, 0.574914f, 0.364441f, 0.356331f) },
+		{ FIntPoint(32, 18), FLinearColor(0.5f, 0.5f, 0.5f, 0.5f) },
+		{ FIntPoint(50, 30), FLinearColor(0.442319f, 0.431799f, 0.605897f, 0.624635f) },
+		{ FIntPoint(63, 35), FLinearColor(0.396801f, 0.399805f, 0.722540f, 0.714039f) },
+		{ FIntPoint(20, 27), FLinearColor(0.537889f, 0.449518f, 0.434146f, 0.587624f) },
+	};
+	TestGoldenPixels(*this, TEXT("LensDistortion golden"), Reference, Resolution, GoldenPixels, 1.e-4f);
+
+	UWorld* World = FindGPUTestWorld();
+	if (!World)
+	{
+		AddInfo(TEXT("No SM5 RHI, skipping the GPU readback."));
+		return true;
+	}
+
+	struct FLensDistortionTestCase
+	{
+		const TCHAR* Name;
+		ETextureRenderTargetFormat Format;
+		bool bUseCompute;
+		int32 CacheBudgetMB;
+		float Tolerance;
+	};
+
+	// The float cases disable the cache so that every case draws the map, otherwise the second one would copy the map of the first.
+	// The grid raster pass draws the map, or the compute pass into a render target with UAV support.
+	// The 8 bit render target is sRGB: drawn directly, then copied from an sRGB map of the cache. Its tolerance covers the 8 bit steps.
+	const FLensDistortionTestCase TestCases[] =
+	{
+		{ TEXT("grid"), RTF_RGBA32f, false, 0, 0.002f },
+		{ TEXT("compute"), RTF_RGBA32f, true, 0, 0.002f },
+		{ TEXT("sRGB"), RTF_RGBA8, false, 0, 0.005f },
+		{ TEXT("sRGB cached"), RTF_RGBA8, false, 64, 0.005f },
+	};
+
+	for (const FLensDistortionTestCase& TestCase : TestCases)
+	{
+		const FScopedTestCVarOverride CacheBudget(TEXT("r.ShaderTest.LensDistortion.CacheBudgetMB"), TestCase.CacheBudgetMB);
+		const FScopedTestCVarOverride UseCompute(TEXT("r.ShaderTest.LensDistortion.UseCompute"), TestCase.bUseCompute ? 1 : 0);
+
+		TStrongObjectPtr<UTextureRenderTarget2D> RenderTarget = CreateTestRenderTarget(Resolution, TestCase.bUseCompute, TestCase.Format);
+		CameraModel.DrawUVDisplacementToRenderTarget(World, HorizontalFOV, AspectRatio, 1.f, RenderTarget.Get(), OutputMultiply, OutputAdd);
+
+		TArray<FLinearColor> Readback;
+		if (!ReadbackTestRenderTarget(RenderTarget.Get(), Readback))
+		{
+			AddError(TEXT("LensDistortion: failed to read the render target back"));
+			continue;
+		}
+
+		// Only the pixels covered by the grid pass are compared.
+		const FLensDistortionDisplacementComparison Comparison = CompareUVDisplacementToCPU(CompiledCameraModel, Resolution, Readback, TestCase.Tolerance);
+		AddInfo(FString::Printf(TEXT("LensDistortion %s: %d/%d pixels above tolerance, max error %f, mean error %f"),
+			TestCase.Name, Comparison.NumPixelsAboveTolerance, Comparison.NumComparedPixels, Comparison.MaxError, Comparison.MeanError));
+		TestTrue(TEXT("LensDistortion GPU within tolerance of the CPU reference"), Comparison.IsWithinTolerance());
+		TestTrue(TEXT("LensDistortion GPU pixels compared"), Comparison.NumComparedPixels > 0);
+	}
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShaderTestComputeShaderReferenceTest, "Plugins.ShaderTest.References.ComputeShader", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShaderTestComputeShaderReferenceTest::RunTest(const FString& Parameters)
+{
+	// Golden data, 8 steps at time 1.5 of a 64x64 surface.
+	{
+		const FIntPoint Resolution(64, 64);
+		const float Time = 1.5f;
+		const int32 NumSteps = 8;
+
+		const FShaderTestGoldenPixel GoldenPixels[] =
+		{
+			{ FIntPoint(0, 0), FLinearColor(0.031547f, 0.028891f, 0.027995f, 1.f) },
+			{ FIntPoint(8, 40), FLinearColor(0.074290f, 0.068192f, 0.068128f, 1.f) },
+			{ FIntPoint(16, 16), FLinearColor(0.079059f, 0.073420f, 0.073003f, 1.f) },
+			{ FIntPoint(31, 33), FLinearColor(0.145283f, 0.131791f, 0.136276f, 1.f) },
+			{ FIntPoint(32, 32), FLinearColor(0.137496f, 0.125787f, 0.124880f, 1.f) },
+			{ FIntPoint(40, 20), FLinearColor(0.107659f, 0.105302f, 0.099904f, 1.f) },
+			{ FIntPoint(63, 63), FLinearColor(0.033191f, 0.031202f, 0.030415f, 1.f) },
+		};
+
+		TArray<FLinearColor> Reference;
+		DrawMyComputeShader_CPU(Resolution, Time, NumSteps, Reference);
+		TestGoldenPixels(*this, TEXT("ComputeShader golden"), Reference, Resolution, GoldenPixels, 1.e-4f);
+	}
+
+	UWorld* World = FindGPUTestWorld();
+	if (!World)
+	{
+		AddInfo(TEXT("No SM5 RHI, skipping the GPU readback."));
+		return true;
+	}
+
+	const FIntPoint Resolution(64, 48);
+	const float Time = 3.25f;
+
+	// The draw reads the step count on the render thread.
+	const IConsoleVariable* NumStepsCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ShaderTest.ComputeShader.NumSteps"));
+	const int32 NumSteps = FMath::Max(NumStepsCVar ? NumStepsCVar->GetInt() : 90, 1);
+
+	TArray<FLinearColor> Reference;
+	DrawMyComputeShader_CPU(Resolution, Time, NumSteps, Reference);
+
+	TStrongObjectPtr<UTextureRenderTarget2D> RenderTarget = CreateTestRenderTarget(Resolution, true);
+	UShaderTestLibrary::MyComputerShaderDraw(World, RenderTarget.Get(), Time);
+
+	TArray<FLinearColor> Readback;
+	if (!ReadbackTestRenderTarget(RenderTarget.Get(), Readback))
+	{
+		AddError(TEXT("ComputeShader: failed to read the render target back"));
+		return true;
+	}
+
+	// The fractal iterations amplify the differences of the GPU's sin/pow, a few pixels near its singularities may diverge.
+	TestReadbackAgainstReference(*this, TEXT("ComputeShader"), Readback, Reference, 2.e-3f, 0.01f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShaderTestComputeShaderCPUTest, "Plugins.ShaderTest.References.ComputeShaderCPU", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FShaderTestComputeShaderCPUTest::RunTest(const FString& Parameters)
+{
+	// Not a multiple of the tiles nor of the pixel groups, to cover the partial ones.
+	const FIntPoint Resolution(75, 41);
+	const float Time = 3.25f;
+	const int32 NumSteps = 16;
+
+	TArray<FLinearColor> Reference;
+	DrawMyComputeShader_CPU(Resolution, Time, NumSteps, Reference);
+
+	for (int32 NumWorkers : { 1, 0 })
+	{
+		FImage Image(Resolution.X, Resolution.Y, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+		if (!TestTrue(TEXT("ComputeShader vectorized draw"), DrawMyComputeShaderToImage_CPU(Image, Time, NumSteps, NumWorkers)))
+		{
+			continue;
+		}
+
+		// The vectorized sin/cos/pow are approximations of the scalar ones.
+		TestReadbackAgainstReference(*this, NumWorkers == 1 ? TEXT("ComputeShader vectorized, 1 core") : TEXT("ComputeShader vectorized, all cores"),
+			MakeArrayView(Image.AsRGBA32F().GetData(), Reference.Num()), Reference, 1.e-3f);
+	}
+
+	// The 8 bit images are quantized in the vector registers, within a step of FLinearColor::ToFColor() of the float image.
+	FImage FloatImage(Resolution.X, Resolution.Y, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+	DrawMyComputeShaderToImage_CPU(FloatImage, Time, NumSteps);
+	for (EGammaSpace GammaSpace : { EGammaSpace::Linear, EGammaSpace::sRGB })
+	{
+		FImage Image(Resolution.X, Resolution.Y, ERawImageFormat::BGRA8, GammaSpace);
+		DrawMyComputeShaderToImage_CPU(Image, Time, NumSteps);
+
+		int32 NumPixelsAboveStep = 0;
+		for (int32 Index = 0; Index < Resolution.X * Resolution.Y; Index++)
+		{
+			const FColor Expected = FloatImage.AsRGBA32F()[Index].ToFColor(GammaSpace != EGammaSpace::Linear);
+			const FColor Color = Image.AsBGRA8()[Index];
+			if (FMath::Abs(Color.R - Expected.R) > 1 || FMath::Abs(Color.G - Expected.G) > 1 || FMath::Abs(Color.B - Expected.B) > 1 || Color.A != Expected.A)
+			{
+				NumPixelsAboveStep++;
+			}
+		}
+		TestEqual(GammaSpace == EGammaSpace::Linear ? TEXT("ComputeShader vectorized BGRA8 pixels off by more than a step")
+			: TEXT("ComputeShader vectorized sRGB BGRA8 pixels off by more than a step"), NumPixelsAboveStep, 0);
+	}
+
+	FImage UnsupportedImage(8, 8, ERawImageFormat::G8);
+	AddExpectedError(TEXT("unsupported image format"), EAutomationExpectedErrorFlags::Contains, 1);
+	TestFalse(TEXT("ComputeShader vectorized draw of a G8 image"), DrawMyComputeShaderToImage_CPU(UnsupportedImage, Time, NumSteps));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
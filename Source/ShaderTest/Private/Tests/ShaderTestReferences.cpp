@@ -0,0 +1,132 @@
+#include "Tests/ShaderTestReferences.h"
+
+#include "Async/ParallelFor.h"
+
+
+void DrawFirstShader_CPU(FLinearColor Color, FIntPoint Resolution, TArray<FLinearColor>& OutPixels)
+{
+	check(Resolution.X > 0 && Resolution.Y > 0);
+
+	OutPixels.Init(Color, Resolution.X * Resolution.Y);
+}
+
+
+float LinearToSrgb_CPU(float Linear)
+{
+	// Minimum positive non-denormal, as the shader.
+	Linear = FMath::Max(6.10352e-5f, Linear);
+	return FMath::Min(Linear * 12.92f, FMath::Pow(FMath::Max(Linear, 0.00313067f), 1.f / 2.4f) * 1.055f - 0.055f);
+}
+
+
+void DrawTestTextureShader_CPU(
+	TConstArrayView<FLinearColor> Texture,
+	FIntPoint Resolution,
+	const FTestTextureShaderStructData& StructData,
+	TArray<FLinearColor>& OutPixels)
+{
+	check(Resolution.X > 0 && Resolution.Y > 0);
+	check(Texture.Num() == Resolution.X * Resolution.Y);
+
+	// Only the color slots 0 to 3 tint, see FTestTextureShaderPS::GetPermutationVector().
+	const FLinearColor Slots[] = { StructData.ColorOne, StructData.ColorTwo, StructData.ColorThree, StructData.ColorFour };
+	const bool bTint = StructData.ColorIndex >= 0 && StructData.ColorIndex < 4;
+	const FLinearColor TintColor = bTint ? Slots[StructData.ColorIndex] : FLinearColor::White;
+
+	OutPixels.SetNumUninitialized(Resolution.X * Resolution.Y);
+
+	for (int32 Y = 0; Y < Resolution.Y; Y++)
+	{
+		// MainVS keeps the bottom left originated UVs, the pixel centers land on the texel centers of the flipped row.
+		const FLinearColor* TextureRow = Texture.GetData() + (Resolution.Y - 1 - Y) * Resolution.X;
+		FLinearColor* Row = OutPixels.GetData() + Y * Resolution.X;
+
+		for (int32 X = 0; X < Resolution.X; X++)
+		{
+			FLinearColor Color(TextureRow[X].R, TextureRow[X].G, TextureRow[X].B, 1.f);
+			Color *= TintColor;
+
+			if (StructData.bOutputSRGB)
+			{
+				Color.R = LinearToSrgb_CPU(Color.R);
+				Color.G = LinearToSrgb_CPU(Color.G);
+				Color.B = LinearToSrgb_CPU(Color.B);
+			}
+
+			Row[X] = Color;
+		}
+	}
+}
+
+
+FLinearColor EvaluateMyComputeShader_CPU(FIntPoint PixelPos, FIntPoint OutputSize, float GlobalTime, int32 NumSteps)
+{
+	check(NumSteps > 0);
+
+	const FVector2f UV(float(PixelPos.X) / float(OutputSize.X) - 0.5f, float(PixelPos.Y) / float(OutputSize.Y) - 0.5f);
+	const float Len = UV.Size();
+	const float StepSize = 0.035f * 90.f / float(NumSteps);
+
+	const float T = GlobalTime * 0.1f + ((0.25f + 0.05f * FMath::Sin(GlobalTime * 0.1f)) / (Len + 0.07f)) * 2.2f;
+	const float Si = FMath::Sin(T);
+	const float Co = FMath::Cos(T);
+
+	// Loop invariants of the shader.
+	const float Amplitude1 = 1.8f + FMath::Sin((UV * 13.f).Size() + 0.5f - GlobalTime * 0.2f);
+	const float Amplitude2 = 1.5f + FMath::Sin((UV * 14.5f).Size() + 1.2f - GlobalTime * 0.3f);
+	const float OffsetZ = 1.5f + FMath::Sin(GlobalTime * 0.13f) * 0.1f;
+
+	float V1 = 0.f;
+	float V2 = 0.f;
+	float V3 = 0.f;
+	float S = 0.f;
+
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		// p.xy = mul(p.xy, ma) with ma = { co, si, -si, co }.
+		const float X = S * UV.X;
+		const float Y = S * UV.Y;
+		FVector3f P(X * Co - Y * Si + 0.22f, X * Si + Y * Co + 0.3f, S - OffsetZ);
+
+		for (int32 Iteration = 0; Iteration < 8; Iteration++)
+		{
+			P = P.GetAbs() / (P | P) - FVector3f(0.659f);
+		}
+
+		const float LengthSquared = P | P;
+		V1 += LengthSquared * 0.0015f * Amplitude1;
+		V2 += LengthSquared * 0.0013f * Amplitude2;
+		V3 += FVector2f(P.X * 10.f, P.Y * 10.f).Size() * 0.0003f;
+		S += StepSize;
+	}
+
+	V1 *= FMath::Lerp(0.7f, 0.f, Len);
+	V2 *= FMath::Lerp(0.5f, 0.f, Len);
+	V3 *= FMath::Lerp(0.9f, 0.f, Len);
+
+	const float Add = FMath::Lerp(0.2f, 0.f, Len) * 0.85f + FMath::Lerp(0.f, 0.6f, V3) * 0.3f;
+	const FVector3f Color(V3 * (1.5f + FMath::Sin(GlobalTime * 0.2f) * 0.4f) + Add, (V1 + V3) * 0.3f + Add, V2 + Add);
+
+	return FLinearColor(
+		FMath::Min(FMath::Pow(FMath::Abs(Color.X), 1.2f), 1.f),
+		FMath::Min(FMath::Pow(FMath::Abs(Color.Y), 1.2f), 1.f),
+		FMath::Min(FMath::Pow(FMath::Abs(Color.Z), 1.2f), 1.f),
+		1.f);
+}
+
+
+void DrawMyComputeShader_CPU(FIntPoint OutputSize, float GlobalTime, int32 NumSteps, TArray<FLinearColor>& OutPixels)
+{
+	check(OutputSize.X > 0 && OutputSize.Y > 0);
+
+	OutPixels.SetNumUninitialized(OutputSize.X * OutputSize.Y);
+
+	ParallelFor(OutputSize.Y, [&](int32 Y)
+	{
+		FLinearColor* Row = OutPixels.GetData() + Y * OutputSize.X;
+		for (int32 X = 0; X < OutputSize.X; X++)
+		{
+			Row[X] = EvaluateMyComputeShader_CPU(FIntPoint(X, Y), OutputSize, GlobalTime, NumSteps);
+		}
+	});
+}
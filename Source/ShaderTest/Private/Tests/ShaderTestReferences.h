@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Common/MyShaderTypes.h"
+
+
+/**
+ * Deterministic CPU references of the plugin shaders, evaluated in float like the GPU.
+ * The buffers are top left originated and row major, like the render target readbacks.
+ * The reference of GlobalShaderExample.usf is DrawUVDisplacementToBuffer_CPU() of LensDistortionCPU.h.
+ */
+
+/** FirstShader.usf, fills the whole target with Color. */
+void DrawFirstShader_CPU(FLinearColor Color, FIntPoint Resolution, TArray<FLinearColor>& OutPixels);
+
+/** LinearToSrgb() of GammaCorrectionCommon.ush, the branchless version of the SM5 shaders. */
+float LinearToSrgb_CPU(float Linear);
+
+/** TestTextureShader.usf drawn into a target of the texture's resolution, each pixel samples its texel vertically flipped.
+ * @param Texture Top left originated texels of a Resolution texture, alpha is ignored.
+ */
+void DrawTestTextureShader_CPU(
+	TConstArrayView<FLinearColor> Texture,
+	FIntPoint Resolution,
+	const FTestTextureShaderStructData& StructData,
+	TArray<FLinearColor>& OutPixels);
+
+/** TestComputeShader.usf at one pixel of an OutputSize surface. */
+FLinearColor EvaluateMyComputeShader_CPU(FIntPoint PixelPos, FIntPoint OutputSize, float GlobalTime, int32 NumSteps);
+
+/** TestComputeShader.usf over the whole OutputSize surface, rows spread across cores. */
+void DrawMyComputeShader_CPU(FIntPoint OutputSize, float GlobalTime, int32 NumSteps, TArray<FLinearColor>& OutPixels);
@@ -0,0 +1,193 @@
+#include "TextureShader/TestTextureArrayCache.h"
+#include "Common/ShaderTestStats.h"
+#include "Common/ShaderTestPassProfiler.h"
+
+#include "RenderTargetPool.h"
+#include "RenderGraphUtils.h"
+#include "RenderUtils.h"
+
+
+static TAutoConsoleVariable<int32> CVarTextureArrayMaxSlices(
+	TEXT("r.ShaderTest.TextureArray.MaxSlices"),
+	64,
+	TEXT("Slices of a texture array of the sprite sources before the least recently used ones are reused.\n")
+	TEXT("A draw with more sources than that still grows the array."),
+	ECVF_RenderThreadSafe);
+
+TGlobalResource<FTestTextureArrayCache> GTestTextureArrayCache;
+
+
+FTestTextureArrayCache::FLayout::FLayout(FRHITexture* Texture)
+{
+	const FIntVector TextureSize = Texture->GetSizeXYZ();
+	Size = FIntPoint(TextureSize.X, TextureSize.Y);
+	Format = Texture->GetFormat();
+	bSRGB = EnumHasAnyFlags(Texture->GetFlags(), TexCreate_SRGB);
+	NumMips = Texture->GetNumMips();
+}
+
+
+FRDGTextureRef FTestTextureArrayCache::AddUpdatePasses(
+	FRDGBuilder& GraphBuilder,
+	TConstArrayView<FTestTextureArraySource> Sources,
+	TArray<uint32>& OutSlices)
+{
+	check(IsInRenderingThread());
+	check(Sources.Num() > 0);
+
+	if (!Sources[0].Texture)
+	{
+		return nullptr;
+	}
+
+	FLayout Layout(Sources[0].Texture);
+	for (const FTestTextureArraySource& Source : Sources)
+	{
+		if (!Source.Texture || !Source.Texture->GetTexture2D())
+		{
+			return nullptr;
+		}
+
+		const FLayout SourceLayout(Source.Texture);
+		if (!SourceLayout.IsCompatible(Layout))
+		{
+			return nullptr;
+		}
+		Layout.NumMips = FMath::Min(Layout.NumMips, SourceLayout.NumMips);
+	}
+
+	FArray& Array = Arrays.FindOrAdd(Layout);
+
+	for (FSlice& Slice : Array.Slices)
+	{
+		// Only referenced by the cache, the source has been released or re-created.
+		if (Slice.Source && Slice.Source->GetRefCount() == 1)
+		{
+			Slice.Source = nullptr;
+		}
+	}
+
+	// The slices used by this update are not reused for another of its sources.
+	const uint64 UpdateStart = UseCounter + 1;
+
+	TArray<int32, TInlineAllocator<16>> SlicesToCopy;
+	OutSlices.SetNumUninitialized(Sources.Num());
+
+	for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); SourceIndex++)
+	{
+		const FTestTextureArraySource& Source = Sources[SourceIndex];
+
+		int32 SliceIndex = Array.Slices.IndexOfByPredicate([&Source](const FSlice& Slice) { return Slice.Source == Source.Texture; });
+		if (SliceIndex == INDEX_NONE)
+		{
+			SliceIndex = AllocateSlice(GraphBuilder, Layout, Array, UpdateStart);
+			Array.Slices[SliceIndex].Source = Source.Texture;
+			SlicesToCopy.Add(SliceIndex);
+		}
+		else if (Source.bDynamic && Array.Slices[SliceIndex].LastUsed < UpdateStart)
+		{
+			SlicesToCopy.Add(SliceIndex);
+		}
+
+		Array.Slices[SliceIndex].LastUsed = ++UseCounter;
+		OutSlices[SourceIndex] = SliceIndex;
+	}
+
+	FRDGTextureRef ArrayTexture = GraphBuilder.RegisterExternalTexture(Array.Texture);
+
+	for (int32 SliceIndex : SlicesToCopy)
+	{
+		FRDGTextureRef SourceTexture = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(Array.Slices[SliceIndex].Source, TEXT("TestTextureArraySource")));
+
+		FRHICopyTextureInfo CopyInfo;
+		CopyInfo.DestSliceIndex = SliceIndex;
+		CopyInfo.NumMips = Layout.NumMips;
+		AddCopyTexturePass(GraphBuilder, SourceTexture, ArrayTexture, CopyInfo);
+
+		INC_DWORD_STAT(STAT_ShaderTest_TextureArraySliceUploads);
+		FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::TextureShader, 1);
+	}
+
+	return ArrayTexture;
+}
+
+
+int32 FTestTextureArrayCache::AllocateSlice(FRDGBuilder& GraphBuilder, const FLayout& Layout, FArray& Array, uint64 UpdateStart)
+{
+	const int32 FreeSlice = Array.Slices.IndexOfByPredicate([](const FSlice& Slice) { return !Slice.Source; });
+	if (FreeSlice != INDEX_NONE)
+	{
+		return FreeSlice;
+	}
+
+	const int32 NumSlices = Array.Slices.Num();
+	const int32 MaxSlices = FMath::Max(CVarTextureArrayMaxSlices.GetValueOnRenderThread(), 1);
+
+	if (NumSlices >= MaxSlices)
+	{
+		int32 LeastRecentlyUsed = INDEX_NONE;
+		for (int32 SliceIndex = 0; SliceIndex < NumSlices; SliceIndex++)
+		{
+			const uint64 LastUsed = Array.Slices[SliceIndex].LastUsed;
+			if (LastUsed < UpdateStart && (LeastRecentlyUsed == INDEX_NONE || LastUsed < Array.Slices[LeastRecentlyUsed].LastUsed))
+			{
+				LeastRecentlyUsed = SliceIndex;
+			}
+		}
+
+		if (LeastRecentlyUsed != INDEX_NONE)
+		{
+			Array.Slices[LeastRecentlyUsed].Source = nullptr;
+			return LeastRecentlyUsed;
+		}
+	}
+
+	// Doubles the array, up to the max slices unless this update alone uses all of them.
+	const int32 NewNumSlices = NumSlices >= MaxSlices ? NumSlices * 2 : FMath::Clamp(NumSlices * 2, 4, MaxSlices);
+	ResizeArray(GraphBuilder, Layout, Array, NewNumSlices);
+	return NumSlices;
+}
+
+
+void FTestTextureArrayCache::ResizeArray(FRDGBuilder& GraphBuilder, const FLayout& Layout, FArray& Array, int32 NumSlices)
+{
+	FPooledRenderTargetDesc Desc(FPooledRenderTargetDesc::Create2DArrayDesc(
+		Layout.Size, Layout.Format, FClearValueBinding::None, Layout.bSRGB ? TexCreate_SRGB : TexCreate_None, TexCreate_ShaderResource, false, NumSlices, Layout.NumMips));
+	TRefCountPtr<IPooledRenderTarget> Texture;
+	GRenderTargetPool.FindFreeElement(GraphBuilder.RHICmdList, Desc, Texture, TEXT("TestTextureArray"));
+
+	// Keeps the slices already uploaded.
+	if (Array.Texture)
+	{
+		FRHICopyTextureInfo CopyInfo;
+		CopyInfo.NumSlices = Array.Slices.Num();
+		CopyInfo.NumMips = Layout.NumMips;
+		AddCopyTexturePass(GraphBuilder, GraphBuilder.RegisterExternalTexture(Array.Texture), GraphBuilder.RegisterExternalTexture(Texture), CopyInfo);
+		FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::TextureShader, 1);
+	}
+
+	const uint64 SizeInBytes = uint64(CalcTextureSize(Layout.Size.X, Layout.Size.Y, Layout.Format, Layout.NumMips)) * NumSlices;
+	DEC_MEMORY_STAT_BY(STAT_ShaderTest_TextureArrayMemory, Array.SizeInBytes);
+	INC_MEMORY_STAT_BY(STAT_ShaderTest_TextureArrayMemory, SizeInBytes);
+
+	Array.Texture = Texture;
+	Array.Slices.SetNum(NumSlices);
+	Array.SizeInBytes = SizeInBytes;
+}
+
+
+void FTestTextureArrayCache::Empty()
+{
+	for (const TPair<FLayout, FArray>& Pair : Arrays)
+	{
+		DEC_MEMORY_STAT_BY(STAT_ShaderTest_TextureArrayMemory, Pair.Value.SizeInBytes);
+	}
+	Arrays.Empty();
+	UseCounter = 0;
+}
+
+
+void FTestTextureArrayCache::ReleaseRHI()
+{
+	Empty();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderResource.h"
+#include "RendererInterface.h"
+#include "RenderGraphDefinitions.h"
+
+
+/** Source texture of a texture array slice. */
+struct FTestTextureArraySource
+{
+	FTextureRHIRef Texture;
+	/** Copied on every update, for the render targets whose content changes without the texture changing. */
+	bool bDynamic = false;
+};
+
+
+/**
+ * Render thread cache of the texture arrays packing the source textures of the texture shader sprites, one array per
+ * size, format, sRGB sampling and mip count. The arrays have the mips common to the sources of the draw, so sources with
+ * different mip counts still share an array. A source keeps its slice while it is alive, so only the new, changed or
+ * dynamic sources are copied.
+ *
+ * The slices of the released sources are reused first, then the least recently used ones past r.ShaderTest.TextureArray.MaxSlices.
+ */
+class FTestTextureArrayCache : public FRenderResource
+{
+public:
+	/** Adds the copies of the sources missing from their array and returns the array, OutSlices[i] is the slice of Sources[i].
+	 *  Returns nullptr when the sources don't share the same size, format and sRGB sampling.
+	 */
+	FRDGTextureRef AddUpdatePasses(
+		FRDGBuilder& GraphBuilder,
+		TConstArrayView<FTestTextureArraySource> Sources,
+		TArray<uint32>& OutSlices);
+
+	/** Forgets every texture array. */
+	void Empty();
+
+	// FRenderResource interface.
+	virtual void ReleaseRHI() override;
+
+private:
+	struct FLayout
+	{
+		FIntPoint Size;
+		EPixelFormat Format;
+		bool bSRGB;
+		/** Mips of the array, at most the ones of each source. */
+		uint32 NumMips;
+
+		explicit FLayout(FRHITexture* Texture);
+
+		/** Whether the texture can be copied in a slice of an array of this layout. */
+		bool IsCompatible(const FLayout& Other) const
+		{
+			return Size == Other.Size && Format == Other.Format && bSRGB == Other.bSRGB;
+		}
+
+		bool operator==(const FLayout& Other) const
+		{
+			return IsCompatible(Other) && NumMips == Other.NumMips;
+		}
+
+		friend uint32 GetTypeHash(const FLayout& Layout)
+		{
+			return HashCombine(GetTypeHash(Layout.Size), HashCombine(uint32(Layout.Format) | (uint32(Layout.bSRGB) << 31), Layout.NumMips));
+		}
+	};
+
+	struct FSlice
+	{
+		/** Null for a free slice, the reference keeps the source from being recycled into another texture at the same address. */
+		FTextureRHIRef Source;
+		uint64 LastUsed = 0;
+	};
+
+	struct FArray
+	{
+		TRefCountPtr<IPooledRenderTarget> Texture;
+		TArray<FSlice> Slices;
+		uint64 SizeInBytes = 0;
+	};
+
+	/** Slice of Array for a source missing from it, growing the array when every slice is used by this update. */
+	int32 AllocateSlice(FRDGBuilder& GraphBuilder, const FLayout& Layout, FArray& Array, uint64 UpdateStart);
+	void ResizeArray(FRDGBuilder& GraphBuilder, const FLayout& Layout, FArray& Array, int32 NumSlices);
+
+	TMap<FLayout, FArray> Arrays;
+	uint64 UseCounter = 0;
+};
+
+extern TGlobalResource<FTestTextureArrayCache> GTestTextureArrayCache;
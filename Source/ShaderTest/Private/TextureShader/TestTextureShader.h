@@ -5,20 +5,42 @@
 #include "Common/TestShaderUtils.h"
 #include "Common/MyGlobalShaderBase.h"
 
-class FTestTextureShaderVS : public FMyGlobalShaderBase
+/** One sprite of the instanced mode, matches FTestTextureSprite of TestTextureShader.usf. */
+struct FTestTextureSpriteInstance
 {
-	DECLARE_SHADER_TYPE(FTestTextureShaderVS, Global);
+	/** Min and max corners of the sprite in clip space. */
+	FVector4f PositionRect;
+	/** Min and max UVs of the texture mapped on the sprite, top left originated. */
+	FVector4f UVRect;
+	FLinearColor Tint;
+	/** Slice of the texture array, 0 out of the TEXTURE_ARRAY permutation. */
+	uint32 TextureSlice;
+	/** Pads the structure stride to 16 bytes on both sides. */
+	uint32 Padding[3];
+};
+
+static_assert(sizeof(FTestTextureSpriteInstance) == 64, "FTestTextureSpriteInstance must match the stride of FTestTextureSprite in the shader.");
+
+/** Instanced mode, both shaders are compiled with INSTANCED. */
+class FTestTextureShaderInstancedDim : SHADER_PERMUTATION_BOOL("INSTANCED");
 
+class FTestTextureShaderVS : public FMyGlobalShaderBase
+{
 public:
-	FTestTextureShaderVS() {}
+	DECLARE_GLOBAL_SHADER(FTestTextureShaderVS);
+	SHADER_USE_PARAMETER_STRUCT(FTestTextureShaderVS, FMyGlobalShaderBase);
 
-	FTestTextureShaderVS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
-		: FMyGlobalShaderBase(Initializer)
-	{
+	/** Draws a quad per instance of Sprites instead of the full screen triangle. */
+	using FInstancedDim = FTestTextureShaderInstancedDim;
 
-	}
+	using FPermutationDomain = TShaderPermutationDomain<FInstancedDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FTestTextureSpriteInstance>, Sprites)
+	END_SHADER_PARAMETER_STRUCT()
 };
 
+/** Four color slots selected per pixel, only bound by the DYNAMIC_BRANCH reference permutation. */
 BEGIN_UNIFORM_BUFFER_STRUCT(FSimpleUniformStruct, )
 	SHADER_PARAMETER(FVector4f, ColorOne)
 	SHADER_PARAMETER(FVector4f, ColorTwo)
@@ -27,15 +49,71 @@ BEGIN_UNIFORM_BUFFER_STRUCT(FSimpleUniformStruct, )
 	SHADER_PARAMETER(int32, ColorIndex)
 END_UNIFORM_BUFFER_STRUCT()
 
+/** Color of the slot selected on the CPU. */
+BEGIN_UNIFORM_BUFFER_STRUCT(FTintUniformStruct, )
+	SHADER_PARAMETER(FVector4f, TintColor)
+END_UNIFORM_BUFFER_STRUCT()
+
 class FTestTextureShaderPS : public FMyGlobalShaderBase
 {
 public:
 	DECLARE_GLOBAL_SHADER(FTestTextureShaderPS);
 	SHADER_USE_PARAMETER_STRUCT(FTestTextureShaderPS, FMyGlobalShaderBase);
 
+	/** Multiplies the texture by TintUniformStruct.TintColor, the texture is passed through otherwise. */
+	class FTintDim : SHADER_PERMUTATION_BOOL("TINT");
+	/** Encodes the output in sRGB, for the render targets not using an sRGB format. */
+	class FOutputSRGBDim : SHADER_PERMUTATION_BOOL("OUTPUT_SRGB");
+	/** Selects the color slot per pixel from SimpleUniformStruct, the reference of the permutation benchmark. */
+	class FDynamicBranchDim : SHADER_PERMUTATION_BOOL("DYNAMIC_BRANCH");
+	/** Multiplies the texture by the tint of the sprite, drawn with the instanced vertex shader. */
+	using FInstancedDim = FTestTextureShaderInstancedDim;
+	/** Samples the slice of the sprite in MyTextureArray instead of MyTextrue, for the sprites of several sources. */
+	class FTextureArrayDim : SHADER_PERMUTATION_BOOL("TEXTURE_ARRAY");
+
+	using FPermutationDomain = TShaderPermutationDomain<FTintDim, FOutputSRGBDim, FDynamicBranchDim, FInstancedDim, FTextureArrayDim>;
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_TEXTURE(Texture2D, MyTextrue)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2DArray, MyTextureArray)
 		SHADER_PARAMETER_SAMPLER(SamplerState, MyTextureSampler)
+		SHADER_PARAMETER_STRUCT_REF(FTintUniformStruct, TintUniformStruct)
 		SHADER_PARAMETER_STRUCT_REF(FSimpleUniformStruct, SimpleUniformStruct)
 	END_SHADER_PARAMETER_STRUCT()
-};
\ No newline at end of file
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+		// The dynamic branch replaces the tint, the sprite tints replace both, only the sprites have a slice.
+		if (PermutationVector.Get<FDynamicBranchDim>() && PermutationVector.Get<FTintDim>())
+		{
+			return false;
+		}
+		if (PermutationVector.Get<FInstancedDim>() && (PermutationVector.Get<FDynamicBranchDim>() || PermutationVector.Get<FTintDim>()))
+		{
+			return false;
+		}
+		if (PermutationVector.Get<FTextureArrayDim>() && !PermutationVector.Get<FInstancedDim>())
+		{
+			return false;
+		}
+		return FMyGlobalShaderBase::ShouldCompilePermutation(Parameters);
+	}
+
+	/** Picks the permutation of the struct data, the tint only applies to the color slots 0 to 3. */
+	static FPermutationDomain GetPermutationVector(const FTestTextureShaderStructData& StructData)
+	{
+		FPermutationDomain PermutationVector;
+		PermutationVector.Set<FTintDim>(StructData.ColorIndex >= 0 && StructData.ColorIndex < 4);
+		PermutationVector.Set<FOutputSRGBDim>(StructData.bOutputSRGB);
+		return PermutationVector;
+	}
+
+	/** Color of the selected slot. */
+	static FLinearColor GetTintColor(const FTestTextureShaderStructData& StructData)
+	{
+		const FLinearColor Colors[] = { StructData.ColorOne, StructData.ColorTwo, StructData.ColorThree, StructData.ColorFour };
+		return Colors[FMath::Clamp(StructData.ColorIndex, 0, 3)];
+	}
+};
@@ -1,130 +1,522 @@
 
 #include "ShaderTestLibrary.h"
+#include "ShaderTestPasses.h"
 #include "TextureShader/TestTextureShader.h"
+#include "TextureShader/TestTextureArrayCache.h"
+#include "Common/ShaderTestFrameGraph.h"
+#include "Common/ShaderTestPassProfiler.h"
+#include "GameFramework/Actor.h"
+#include "RenderGraphUtils.h"
+#include "RenderTargetPool.h"
 
-class FMyTextureVertexDeclaration : public FRenderResource
+BEGIN_SHADER_PARAMETER_STRUCT(FTestTextureShaderPassParameters, )
+	SHADER_PARAMETER_STRUCT_INCLUDE(FTestTextureShaderPS::FParameters, PS)
+	// Texture of the graph bound to PS.MyTextrue when the pass executes, for AddTestTextureShaderPass().
+	RDG_TEXTURE_ACCESS(InputTexture, ERHIAccess::SRVGraphics)
+	RENDER_TARGET_BINDING_SLOTS()
+END_SHADER_PARAMETER_STRUCT()
+
+BEGIN_SHADER_PARAMETER_STRUCT(FTestTextureShaderSpritesPassParameters, )
+	SHADER_PARAMETER_STRUCT_INCLUDE(FTestTextureShaderVS::FParameters, VS)
+	SHADER_PARAMETER_STRUCT_INCLUDE(FTestTextureShaderPS::FParameters, PS)
+	RENDER_TARGET_BINDING_SLOTS()
+END_SHADER_PARAMETER_STRUCT()
+
+/** Source texture of the sprites, resolved on the render thread. */
+struct FTestTextureSpriteSource
 {
-public:
-	FVertexDeclarationRHIRef VertexDeclarationRHI;
+	FTextureReferenceRHIRef TextureReference;
+	bool bDynamic = false;
+};
+
+static void ExecuteTestTextureShader(
+	FRHICommandList& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FIntPoint DrawTargetResolution,
+	FTestTextureShaderPS::FPermutationDomain PermutationVector,
+	const FTestTextureShaderPS::FParameters& Parameters,
+	uint32 NumDraws = 1)
+{
+	FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+	TShaderMapRef<FTestTextureShaderVS> VertexShader(GlobalShaderMap);
+	TShaderMapRef<FTestTextureShaderPS> PixelShader(GlobalShaderMap, PermutationVector);
+
+	// Set the graphic pipeline state.
+	FGraphicsPipelineStateInitializer GraphicsPSOInit;
+	RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+	GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+	GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+	GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+	GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+	GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+	UTestShaderUtils::SetupFullScreenTriangle(GraphicsPSOInit);
+	SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
+
+	// Update viewport.
+	RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);
 
-	virtual void InitRHI() override
+	SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), Parameters);
+
+	for (uint32 DrawIndex = 0; DrawIndex < NumDraws; DrawIndex++)
 	{
-		FVertexDeclarationElementList Elements;
-		uint32 Stride = sizeof(FMyTextureVertex);
-		Elements.Add(FVertexElement(0, STRUCT_OFFSET(FMyTextureVertex, Position), VET_Float4, 0, Stride));
-		Elements.Add(FVertexElement(0, STRUCT_OFFSET(FMyTextureVertex, UV), VET_Float2, 1, Stride));
-		VertexDeclarationRHI = RHICreateVertexDeclaration(Elements);
+		UTestShaderUtils::DrawFullScreenTriangle(RHICmdList);
 	}
+}
+
+/** Adds the tinted draw of StructData into OutputTexture, the texture is set in Parameters by the caller. */
+static void AddTestTextureShaderTintPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	const FTestTextureShaderStructData& StructData,
+	FTestTextureShaderPassParameters* Parameters)
+{
+	SHADERTEST_PASS_SCOPE(TextureShader, RenderThread);
+	SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, TextureShader);
+
+	// Update shader parameters, the passthrough permutation doesn't read the tint.
+	const FTestTextureShaderPS::FPermutationDomain PermutationVector = FTestTextureShaderPS::GetPermutationVector(StructData);
 
-	virtual void ReleaseRHI() override
+	Parameters->PS.MyTextureSampler = TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+	if (PermutationVector.Get<FTestTextureShaderPS::FTintDim>())
 	{
-		VertexDeclarationRHI.SafeRelease();
+		FTintUniformStruct TintUniformStruct;
+		TintUniformStruct.TintColor = FTestTextureShaderPS::GetTintColor(StructData);
+		Parameters->PS.TintUniformStruct = TUniformBufferRef<FTintUniformStruct>::CreateUniformBufferImmediate(TintUniformStruct, UniformBuffer_SingleFrame);
+		FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::TextureShader, sizeof(FTintUniformStruct));
+	}
+	Parameters->RenderTargets[0] = FRenderTargetBinding(OutputTexture, ERenderTargetLoadAction::ENoAction);
+
+	const FIntPoint DrawTargetResolution = OutputTexture->Desc.Extent;
+	GraphBuilder.AddPass(
+		RDG_EVENT_NAME("DrawTestShader"),
+		Parameters,
+		ERDGPassFlags::Raster,
+		[FeatureLevel, DrawTargetResolution, PermutationVector, Parameters](FRHICommandList& RHICmdList)
+		{
+			FTestTextureShaderPS::FParameters PSParameters = Parameters->PS;
+			if (Parameters->InputTexture)
+			{
+				PSParameters.MyTextrue = Parameters->InputTexture->GetRHI();
+			}
+			ExecuteTestTextureShader(RHICmdList, FeatureLevel, DrawTargetResolution, PermutationVector, PSParameters);
+		});
+
+	FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::TextureShader, 1);
+}
+
+void AddTestTextureShaderPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	const FTestTextureShaderStructData& StructData,
+	FRDGTextureRef InputTexture)
+{
+	check(InputTexture);
+
+	FTestTextureShaderPassParameters* Parameters = GraphBuilder.AllocParameters<FTestTextureShaderPassParameters>();
+	Parameters->InputTexture = InputTexture;
+	AddTestTextureShaderTintPass(GraphBuilder, FeatureLevel, OutputTexture, StructData, Parameters);
+}
+
+static void DrawTestTextureShaderRenderTarget_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FTextureRenderTargetResource* OutTextureRenderTargetResource,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FName RenderTargetName,
+	FTestTextureShaderStructData StructData,
+	FTextureReferenceRHIRef TextureReferenceRHI)
+{
+	check(IsInRenderingThread());
+
+	SHADERTEST_PASS_SCOPE(TextureShader, RenderThread);
+
+	FTexture2DRHIRef RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
+
+	FShaderTestFrameGraph::AddPasses(RHICmdList, [RenderTargetTexture, FeatureLevel, StructData, TextureReferenceRHI](FRDGBuilder& GraphBuilder)
+	{
+		FRDGTextureRef RDGRenderTarget = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("TestTexture_RDG_RT")));
+
+		// The texture reference is resolved when the pass executes, it is not tracked by the graph.
+		FTestTextureShaderPassParameters* Parameters = GraphBuilder.AllocParameters<FTestTextureShaderPassParameters>();
+		Parameters->PS.MyTextrue = TextureReferenceRHI;
+		AddTestTextureShaderTintPass(GraphBuilder, FeatureLevel, RDGRenderTarget, StructData, Parameters);
+
+		GraphBuilder.SetTextureAccessFinal(RDGRenderTarget, ERHIAccess::SRVMask);
+	});
+}
+
+static void ExecuteTestTextureShaderSprites(
+	FRHICommandList& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FIntPoint DrawTargetResolution,
+	bool bOutputSRGB,
+	bool bTextureArray,
+	const FTestTextureShaderSpritesPassParameters& Parameters,
+	uint32 NumSprites)
+{
+	FTestTextureShaderVS::FPermutationDomain VSPermutationVector;
+	VSPermutationVector.Set<FTestTextureShaderVS::FInstancedDim>(true);
+
+	FTestTextureShaderPS::FPermutationDomain PSPermutationVector;
+	PSPermutationVector.Set<FTestTextureShaderPS::FInstancedDim>(true);
+	PSPermutationVector.Set<FTestTextureShaderPS::FOutputSRGBDim>(bOutputSRGB);
+	PSPermutationVector.Set<FTestTextureShaderPS::FTextureArrayDim>(bTextureArray);
+
+	FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+	TShaderMapRef<FTestTextureShaderVS> VertexShader(GlobalShaderMap, VSPermutationVector);
+	TShaderMapRef<FTestTextureShaderPS> PixelShader(GlobalShaderMap, PSPermutationVector);
+
+	// Same states as the full screen triangle, the sprite corners are generated from SV_VertexID too.
+	FGraphicsPipelineStateInitializer GraphicsPSOInit;
+	RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+	GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+	GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+	GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+	GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+	GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+	UTestShaderUtils::SetupFullScreenTriangle(GraphicsPSOInit);
+	SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
+
+	RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);
+
+	SetShaderParameters(RHICmdList, VertexShader, VertexShader.GetVertexShader(), Parameters.VS);
+	SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), Parameters.PS);
+
+	// Two triangles per sprite.
+	RHICmdList.DrawPrimitive(0, 2, NumSprites);
+}
+
+static void DrawTestTextureShaderSprites_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FTextureRenderTargetResource* OutTextureRenderTargetResource,
+	ERHIFeatureLevel::Type FeatureLevel,
+	TArray<FTestTextureSpriteDesc>&& Sprites,
+	bool bOutputSRGB,
+	bool bClearRenderTarget,
+	TArray<FTestTextureSpriteSource>&& Sources)
+{
+	check(IsInRenderingThread());
+
+	SHADERTEST_PASS_SCOPE(TextureShader, RenderThread);
+
+	FTexture2DRHIRef RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
+
+	FShaderTestFrameGraph::AddPasses(RHICmdList,
+		[RenderTargetTexture, FeatureLevel, Sprites = MoveTemp(Sprites), bOutputSRGB, bClearRenderTarget, Sources = MoveTemp(Sources)](FRDGBuilder& GraphBuilder)
+	{
+		SHADERTEST_PASS_SCOPE(TextureShader, RenderThread);
+		SHADERTEST_RDG_GPU_SCOPE(GraphBuilder, TextureShader);
+
+		FRDGTextureRef RDGRenderTarget = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(RenderTargetTexture, TEXT("TestTextureSprites_RDG_RT")));
+		GraphBuilder.SetTextureAccessFinal(RDGRenderTarget, ERHIAccess::SRVMask);
+
+		if (Sprites.Num() == 0)
+		{
+			AddClearRenderTargetPass(GraphBuilder, RDGRenderTarget);
+			FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::TextureShader, 1);
+			return;
+		}
+
+		// Several sources are packed into a texture array, the sprites pick their slice.
+		const bool bTextureArray = Sources.Num() > 1;
+		FRDGTextureRef TextureArray = nullptr;
+		TArray<uint32> Slices;
+		if (bTextureArray)
+		{
+			TArray<FTestTextureArraySource, TInlineAllocator<16>> ArraySources;
+			for (const FTestTextureSpriteSource& Source : Sources)
+			{
+				ArraySources.Add({ Source.TextureReference->GetReferencedTexture(), Source.bDynamic });
+			}
+
+			TextureArray = GTestTextureArrayCache.AddUpdatePasses(GraphBuilder, ArraySources, Slices);
+			if (!TextureArray)
+			{
+				UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::DrawTestTextureShaderSpritesFromTextures, the textures don't share the same size, format and sRGB sampling"));
+				return;
+			}
+		}
+
+		// Pixel rects to clip space, the Y axis points up.
+		const FIntPoint DrawTargetResolution = RenderTargetTexture->GetSizeXY();
+		const FVector2f PixelToClipScale(2.f / float(DrawTargetResolution.X), -2.f / float(DrawTargetResolution.Y));
+		const FVector2f PixelToClipBias(-1.f, 1.f);
+
+		TArray<FTestTextureSpriteInstance> Instances;
+		Instances.SetNumUninitialized(Sprites.Num());
+		for (int32 Index = 0; Index < Sprites.Num(); Index++)
+		{
+			const FTestTextureSpriteDesc& Sprite = Sprites[Index];
+			const FVector2f Min = FVector2f(Sprite.Position) * PixelToClipScale + PixelToClipBias;
+			const FVector2f Max = FVector2f(Sprite.Position + Sprite.Size) * PixelToClipScale + PixelToClipBias;
+
+			FTestTextureSpriteInstance& Instance = Instances[Index];
+			Instance.PositionRect = FVector4f(Min.X, Min.Y, Max.X, Max.Y);
+			Instance.UVRect = FVector4f(Sprite.UVMin.X, Sprite.UVMin.Y, Sprite.UVMax.X, Sprite.UVMax.Y);
+			Instance.Tint = Sprite.Tint;
+			Instance.TextureSlice = bTextureArray ? Slices[Sprite.TextureIndex] : 0;
+		}
+
+		FRDGBufferRef SpriteBuffer = CreateStructuredBuffer(
+			GraphBuilder, TEXT("TestTextureSprites"), sizeof(FTestTextureSpriteInstance), Instances.Num(), Instances.GetData(), Instances.Num() * sizeof(FTestTextureSpriteInstance));
+
+		FTestTextureShaderSpritesPassParameters* Parameters = GraphBuilder.AllocParameters<FTestTextureShaderSpritesPassParameters>();
+		Parameters->VS.Sprites = GraphBuilder.CreateSRV(SpriteBuffer);
+		if (bTextureArray)
+		{
+			Parameters->PS.MyTextureArray = TextureArray;
+		}
+		else
+		{
+			Parameters->PS.MyTextrue = Sources[0].TextureReference;
+		}
+		Parameters->PS.MyTextureSampler = TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		Parameters->RenderTargets[0] = FRenderTargetBinding(RDGRenderTarget, bClearRenderTarget ? ERenderTargetLoadAction::EClear : ERenderTargetLoadAction::ELoad);
+
+		const uint32 NumSprites = Instances.Num();
+		GraphBuilder.AddPass(
+			RDG_EVENT_NAME("DrawTestTextureSprites %u", NumSprites),
+			Parameters,
+			ERDGPassFlags::Raster,
+			[FeatureLevel, DrawTargetResolution, bOutputSRGB, bTextureArray, Parameters, NumSprites](FRHICommandList& RHICmdList)
+			{
+				ExecuteTestTextureShaderSprites(RHICmdList, FeatureLevel, DrawTargetResolution, bOutputSRGB, bTextureArray, *Parameters, NumSprites);
+			});
+
+		FShaderTestPassProfiler::AddDrawCalls(EShaderTestPass::TextureShader, 1);
+		FShaderTestPassProfiler::AddUploadedBytes(EShaderTestPass::TextureShader, Instances.Num() * sizeof(FTestTextureSpriteInstance));
+	});
+}
+
+/** GPU time of the benchmark draws of one permutation, in ms. */
+static float BenchmarkTestTextureShaderPermutation(
+	FRHICommandListImmediate& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRHITexture2D* RenderTargetTexture,
+	FTestTextureShaderPS::FPermutationDomain PermutationVector,
+	const FTestTextureShaderPS::FParameters& Parameters,
+	uint32 NumDraws)
+{
+	FRenderQueryRHIRef BeginQuery = RHICreateRenderQuery(RQT_AbsoluteTime);
+	FRenderQueryRHIRef EndQuery = RHICreateRenderQuery(RQT_AbsoluteTime);
+
+	RHICmdList.EndRenderQuery(BeginQuery);
+
+	FRHIRenderPassInfo RPInfo(RenderTargetTexture, ERenderTargetActions::DontLoad_Store);
+	RHICmdList.BeginRenderPass(RPInfo, TEXT("BenchmarkTestTextureShader"));
+	ExecuteTestTextureShader(RHICmdList, FeatureLevel, RenderTargetTexture->GetSizeXY(), PermutationVector, Parameters, NumDraws);
+	RHICmdList.EndRenderPass();
+
+	RHICmdList.EndRenderQuery(EndQuery);
+
+	// Microseconds.
+	uint64 Begin = 0;
+	uint64 End = 0;
+	RHICmdList.ImmediateFlush(EImmediateFlushType::FlushRHIThread);
+	RHIGetRenderQueryResult(BeginQuery, Begin, true);
+	RHIGetRenderQueryResult(EndQuery, End, true);
+	return float(End - Begin) / 1000.f;
+}
+
+static void BenchmarkTestTextureShader_RenderThread(FRHICommandListImmediate& RHICmdList, ERHIFeatureLevel::Type FeatureLevel, FIntPoint Resolution, uint32 NumDraws)
+{
+	check(IsInRenderingThread());
+
+	FPooledRenderTargetDesc Desc(FPooledRenderTargetDesc::Create2DDesc(
+		Resolution, PF_B8G8R8A8, FClearValueBinding::None, TexCreate_None, TexCreate_RenderTargetable | TexCreate_ShaderResource, false));
+	TRefCountPtr<IPooledRenderTarget> RenderTarget;
+	GRenderTargetPool.FindFreeElement(RHICmdList, Desc, RenderTarget, TEXT("BenchmarkTestTextureShader"));
+	FRHITexture2D* RenderTargetTexture = RenderTarget->GetRenderTargetItem().TargetableTexture->GetTexture2D();
+
+	RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::Unknown, ERHIAccess::RTV));
+
+	// Slot 2 so that the dynamic branch walks past a few cases.
+	FSimpleUniformStruct SimpleUniformStruct;
+	SimpleUniformStruct.ColorOne = FVector4f(1.f, 0.f, 0.f, 1.f);
+	SimpleUniformStruct.ColorTwo = FVector4f(0.f, 1.f, 0.f, 1.f);
+	SimpleUniformStruct.ColorThree = FVector4f(0.f, 0.f, 1.f, 1.f);
+	SimpleUniformStruct.ColorFour = FVector4f(1.f, 1.f, 1.f, 1.f);
+	SimpleUniformStruct.ColorIndex = 2;
+
+	FTintUniformStruct TintUniformStruct;
+	TintUniformStruct.TintColor = SimpleUniformStruct.ColorThree;
+
+	FTestTextureShaderPS::FParameters Parameters;
+	Parameters.MyTextrue = GWhiteTexture->TextureRHI;
+	Parameters.MyTextureSampler = TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+	Parameters.TintUniformStruct = TUniformBufferRef<FTintUniformStruct>::CreateUniformBufferImmediate(TintUniformStruct, UniformBuffer_SingleFrame);
+	Parameters.SimpleUniformStruct = TUniformBufferRef<FSimpleUniformStruct>::CreateUniformBufferImmediate(SimpleUniformStruct, UniformBuffer_SingleFrame);
+
+	FTestTextureShaderPS::FPermutationDomain DynamicBranch;
+	DynamicBranch.Set<FTestTextureShaderPS::FDynamicBranchDim>(true);
+
+	FTestTextureShaderPS::FPermutationDomain Tint;
+	Tint.Set<FTestTextureShaderPS::FTintDim>(true);
+
+	FTestTextureShaderPS::FPermutationDomain Passthrough;
+
+	// Warms up the pipeline states.
+	BenchmarkTestTextureShaderPermutation(RHICmdList, FeatureLevel, RenderTargetTexture, DynamicBranch, Parameters, 1);
+	BenchmarkTestTextureShaderPermutation(RHICmdList, FeatureLevel, RenderTargetTexture, Tint, Parameters, 1);
+	BenchmarkTestTextureShaderPermutation(RHICmdList, FeatureLevel, RenderTargetTexture, Passthrough, Parameters, 1);
+
+	const float DynamicBranchMs = BenchmarkTestTextureShaderPermutation(RHICmdList, FeatureLevel, RenderTargetTexture, DynamicBranch, Parameters, NumDraws);
+	const float TintMs = BenchmarkTestTextureShaderPermutation(RHICmdList, FeatureLevel, RenderTargetTexture, Tint, Parameters, NumDraws);
+	const float PassthroughMs = BenchmarkTestTextureShaderPermutation(RHICmdList, FeatureLevel, RenderTargetTexture, Passthrough, Parameters, NumDraws);
+
+	RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::RTV, ERHIAccess::SRVMask));
+
+	UE_LOG(LogTemp, Log, TEXT("BenchmarkTestTextureShader, %s %dx%d, %u draws: dynamic branch %.3f ms, tint permutation %.3f ms, passthrough permutation %.3f ms"),
+		GDynamicRHI->GetName(), Resolution.X, Resolution.Y, NumDraws, DynamicBranchMs, TintMs, PassthroughMs);
+}
+
+/** Also meant for the software rasterizers (e.g. -vulkan with a lavapipe or SwiftShader ICD) on machines without a GPU. */
+static FAutoConsoleCommand GBenchmarkTestTextureShaderCommand(
+	TEXT("ShaderTest.BenchmarkTextureShader"),
+	TEXT("Times the FTestTextureShaderPS tint permutations against the per pixel dynamic branch, with GPU timestamps.\n")
+	TEXT("Args: [NumDraws=100] [SizeX=1920] [SizeY=1080]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const uint32 NumDraws = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100;
+		const FIntPoint Resolution(
+			Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1920,
+			Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 1) : 1080);
+		const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+		ENQUEUE_RENDER_COMMAND(BenchmarkTestTextureShader)(
+			[FeatureLevel, Resolution, NumDraws](FRHICommandListImmediate& RHICmdList)
+			{
+				BenchmarkTestTextureShader_RenderThread(RHICmdList, FeatureLevel, Resolution, NumDraws);
+			});
+	}));
+
+void UShaderTestLibrary::DrawTestTextureShaderRenderTarget(AActor* ContextActor,
+	UTextureRenderTarget2D* RenderTarget,
+	FTestTextureShaderStructData StructData,
+	UTexture* Texture
+)
+{
+	check(IsInGameThread());
+
+	if (!RenderTarget || !ContextActor || !Texture)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::DrawTestTextureShaderRenderTarget, param error"));
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(TextureShader, GameThread);
+
+	FTextureRenderTargetResource* TextureRenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
+	FTextureReferenceRHIRef TextureReferenceRHI = Texture->TextureReference.TextureReferenceRHI;
+
+	UWorld* World = ContextActor->GetWorld();
+	ERHIFeatureLevel::Type RHIFeatureLevel = World->Scene->GetFeatureLevel();
+
+	FName RenderTargetName = RenderTarget->GetFName();
+
+	ENQUEUE_RENDER_COMMAND(CaptureCommand)(
+		[TextureRenderTargetResource, RHIFeatureLevel, StructData, RenderTargetName, TextureReferenceRHI]
+		(FRHICommandListImmediate& RHICmdList)
+		{
+			DrawTestTextureShaderRenderTarget_RenderThread(
+				RHICmdList,
+				TextureRenderTargetResource,
+				RHIFeatureLevel,
+				RenderTargetName,
+				StructData,
+				TextureReferenceRHI);
+		}
+	);
+}
+
+static void EnqueueDrawTestTextureShaderSprites(
+	AActor* ContextActor,
+	UTextureRenderTarget2D* RenderTarget,
+	const TArray<FTestTextureSpriteDesc>& Sprites,
+	TArray<FTestTextureSpriteSource>&& Sources,
+	bool bOutputSRGB,
+	bool bClearRenderTarget)
+{
+	FTextureRenderTargetResource* TextureRenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
+	ERHIFeatureLevel::Type RHIFeatureLevel = ContextActor->GetWorld()->Scene->GetFeatureLevel();
+
+	ENQUEUE_RENDER_COMMAND(CaptureCommand)(
+		[TextureRenderTargetResource, RHIFeatureLevel, Sprites, bOutputSRGB, bClearRenderTarget, Sources = MoveTemp(Sources)]
+		(FRHICommandListImmediate& RHICmdList) mutable
+		{
+			DrawTestTextureShaderSprites_RenderThread(
+				RHICmdList,
+				TextureRenderTargetResource,
+				RHIFeatureLevel,
+				MoveTemp(Sprites),
+				bOutputSRGB,
+				bClearRenderTarget,
+				MoveTemp(Sources));
+		}
+	);
+}
+
+void UShaderTestLibrary::DrawTestTextureShaderSprites(AActor* ContextActor,
+	UTextureRenderTarget2D* RenderTarget,
+	const TArray<FTestTextureSpriteDesc>& Sprites,
+	UTexture* Texture,
+	bool bOutputSRGB,
+	bool bClearRenderTarget
+)
+{
+	check(IsInGameThread());
+
+	if (!RenderTarget || !ContextActor || !Texture)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::DrawTestTextureShaderSprites, param error"));
+		return;
+	}
+
+	if (Sprites.Num() == 0 && !bClearRenderTarget)
+	{
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(TextureShader, GameThread);
+
+	TArray<FTestTextureSpriteSource> Sources;
+	Sources.Add({ Texture->TextureReference.TextureReferenceRHI });
+
+	EnqueueDrawTestTextureShaderSprites(ContextActor, RenderTarget, Sprites, MoveTemp(Sources), bOutputSRGB, bClearRenderTarget);
+}
+
+void UShaderTestLibrary::DrawTestTextureShaderSpritesFromTextures(AActor* ContextActor,
+	UTextureRenderTarget2D* RenderTarget,
+	const TArray<FTestTextureSpriteDesc>& Sprites,
+	const TArray<UTexture*>& Textures,
+	bool bOutputSRGB,
+	bool bClearRenderTarget
+)
+{
+	check(IsInGameThread());
+
+	const bool bValidTextures = Textures.Num() > 0 && !Textures.Contains(nullptr);
+	const bool bValidSprites = !Sprites.ContainsByPredicate([&Textures](const FTestTextureSpriteDesc& Sprite) { return !Textures.IsValidIndex(Sprite.TextureIndex); });
+	if (!RenderTarget || !ContextActor || !bValidTextures || !bValidSprites)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UShaderTestLibrary::DrawTestTextureShaderSpritesFromTextures, param error"));
+		return;
+	}
+
+	if (Sprites.Num() == 0 && !bClearRenderTarget)
+	{
+		return;
+	}
+
+	SHADERTEST_PASS_SCOPE(TextureShader, GameThread);
+
+	TArray<FTestTextureSpriteSource> Sources;
+	Sources.Reserve(Textures.Num());
+	for (UTexture* Texture : Textures)
+	{
+		Sources.Add({ Texture->TextureReference.TextureReferenceRHI, Texture->IsA<UTextureRenderTarget>() });
 	}
-};
 
-// 
-// static void DrawTestTextureShaderRenderTarget_RenderThread(
-// 	FRHICommandListImmediate& RHICmdList,
-// 	FTextureRenderTargetResource* OutTextureRenderTargetResource,
-// 	ERHIFeatureLevel::Type FeatureLevel,
-// 	FName RenderTargetName,
-// 	FTestTextureShaderStructData StructData,
-// 	FTextureReferenceRHIRef TextureReferenceRHI)
-// {
-// 	check(IsInRenderingThread());
-// 
-// 	FRHITexture2D* RenderTargetTexture = OutTextureRenderTargetResource->GetRenderTargetTexture();
-// 
-// 	FRHIRenderPassInfo RPInfo(RenderTargetTexture, ERenderTargetActions::DontLoad_Store, OutTextureRenderTargetResource->TextureRHI);
-// 	RHICmdList.BeginRenderPass(RPInfo, TEXT("DrawTestShader"));
-// 
-// 	FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
-// 	TShaderMapRef<FTestTextureShaderVS> VertexShader(GlobalShaderMap);
-// 	TShaderMapRef<FTestTextureShaderPS> PixelShader(GlobalShaderMap);
-// 
-// 	FMyTextureVertexDeclaration VertexDec;
-// 	VertexDec.InitRHI();
-// 
-// 	// Set the graphic pipeline state.
-// 	FGraphicsPipelineStateInitializer GraphicsPSOInit;
-// 	RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
-// 	GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
-// 	GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
-// 	GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
-// 	GraphicsPSOInit.PrimitiveType = PT_TriangleList;
-// 	GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = VertexDec.VertexDeclarationRHI;
-// 	GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
-// 	GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
-// 	SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit);
-// 
-// 	//�����ӿ�
-// 	FIntPoint DrawTargetResolution(OutTextureRenderTargetResource->GetSizeX(), OutTextureRenderTargetResource->GetSizeY());
-// 	RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);
-// 
-// 	//���ò���
-// 	FSimpleUniformStruct SimpleUniformStruct;
-// 	SimpleUniformStruct.ColorOne = StructData.ColorOne;
-// 	SimpleUniformStruct.ColorTwo = StructData.ColorTwo;
-// 	SimpleUniformStruct.ColorThree = StructData.ColorThree;
-// 	SimpleUniformStruct.ColorFour = StructData.ColorFour;
-// 	SimpleUniformStruct.ColorIndex = StructData.ColorIndex;
-// 
-// 	FTestTextureShaderPS::FParameters Parameters;
-// 	Parameters.MyTextrue = TextureReferenceRHI;
-// 	Parameters.MyTextureSampler = TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
-// 	Parameters.SimpleUniformStruct = TUniformBufferRef<FSimpleUniformStruct>::CreateUniformBufferImmediate(SimpleUniformStruct, UniformBuffer_MultiFrame);
-// 	SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), Parameters);
-// 
-// 	//�����UI��Ϣ
-// 	TArray<FMyTextureVertex> VertexList;
-// 	VertexList.Add(FMyTextureVertex(FVector4(1, 1, 0, 1), FVector2D(1, 1)));
-// 	VertexList.Add(FMyTextureVertex(FVector4(-1, 1, 0, 1), FVector2D(0, 1)));
-// 	VertexList.Add(FMyTextureVertex(FVector4(1, -1, 0, 1), FVector2D(1, 0)));
-// 	VertexList.Add(FMyTextureVertex(FVector4(-1, -1, 0, 1), FVector2D(0, 0)));
-// 	FVertexBufferRHIRef VertexBufferRHI = UTestShaderUtils::CreateVertexBuffer(VertexList);
-// 
-// 	const uint16 Indices[] = { 0, 1, 2, 2, 1, 3 };
-// 	FIndexBufferRHIRef IndexBufferRHI = UTestShaderUtils::CreateIndexBuffer(Indices, 6);
-// 
-// 	RHICmdList.SetStreamSource(0, VertexBufferRHI, 0);
-// 	RHICmdList.DrawIndexedPrimitive(IndexBufferRHI, 0, 0, 4, 0, 2, 1);
-// 
-// 	RHICmdList.EndRenderPass();
-// }
-// 
-// void UShaderTestLibrary::DrawTestTextureShaderRenderTarget(AActor* ContextActor,  //�ܻ�ȡWorld��Actor
-// 	UTextureRenderTarget2D* RenderTarget,  //��ȾĿ��
-// 	FTestTextureShaderStructData StructData,          //��ɫ
-// 	UTexture* Texture                  //����
-// )
-// {
-// 	check(IsInGameThread());
-// 
-// 	if (!RenderTarget || !ContextActor)
-// 	{
-// 		return;
-// 	}
-// 
-// 	FTextureRenderTargetResource* TextureRenderTargetResource = RenderTarget->GameThread_GetRenderTargetResource();
-// 	FTextureReferenceRHIRef TextureReferenceRHI = Texture->TextureReference.TextureReferenceRHI;
-// 
-// 	UWorld* World = ContextActor->GetWorld();
-// 	ERHIFeatureLevel::Type RHIFeatureLevel = World->Scene->GetFeatureLevel();
-// 
-// 	FName RenderTargetName = RenderTarget->GetFName();
-// 
-// 	ENQUEUE_RENDER_COMMAND(CaptureCommand)(
-// 		[TextureRenderTargetResource, RHIFeatureLevel, StructData, RenderTargetName, TextureReferenceRHI]
-// 		(FRHICommandListImmediate& RHICmdList)
-// 		{
-// 			DrawTestTextureShaderRenderTarget_RenderThread(
-// 				RHICmdList,
-// 				TextureRenderTargetResource,
-// 				RHIFeatureLevel,
-// 				RenderTargetName,
-// 				StructData,
-// 				TextureReferenceRHI);
-// 		}
-// 	);
-// }
-// 
+	EnqueueDrawTestTextureShaderSprites(ContextActor, RenderTarget, Sprites, MoveTemp(Sources), bOutputSRGB, bClearRenderTarget);
+}
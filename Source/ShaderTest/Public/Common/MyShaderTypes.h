@@ -19,6 +19,76 @@ struct FTestTextureShaderStructData
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		FLinearColor ColorFour;
 
+	/** Color slot multiplying the texture, any other value draws the texture untinted. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		int32 ColorIndex;
-};
\ No newline at end of file
+
+	/** Encodes the output in sRGB, for the render targets not using an sRGB format. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		bool bOutputSRGB = false;
+};
+
+/** One sprite of UShaderTestLibrary::DrawTestTextureShaderSprites(). */
+USTRUCT(BlueprintType)
+struct FTestTextureSpriteDesc
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Top left corner of the sprite in the render target, in pixels. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FVector2D Position = FVector2D::ZeroVector;
+
+	/** In pixels. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FVector2D Size = FVector2D::ZeroVector;
+
+	/** Texture UVs mapped on the top left corner of the sprite. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FVector2D UVMin = FVector2D::ZeroVector;
+
+	/** Texture UVs mapped on the bottom right corner of the sprite. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FVector2D UVMax = FVector2D::UnitVector;
+
+	/** Multiplies the texture. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		FLinearColor Tint = FLinearColor::White;
+
+	/** Index of the sprite's texture in the Textures of UShaderTestLibrary::DrawTestTextureShaderSpritesFromTextures(). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+		int32 TextureIndex = 0;
+};
+
+/** Stats of a plugin entry point over the latest frame, see UShaderTestLibrary::GetShaderTestPassStats(). */
+USTRUCT(BlueprintType)
+struct FShaderTestPassStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		FName Name;
+
+	/** Calls of the entry point on the game thread. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		int32 NumCalls = 0;
+
+	/** Game thread time of the calls, validating and enqueuing the render commands. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		float GameThreadMs = 0.f;
+
+	/** Render thread time of the calls, setting up the graph passes or recording the RHI commands. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		float RenderThreadMs = 0.f;
+
+	/** GPU time of the passes, from timestamps read back a few frames late. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		float GPUMs = 0.f;
+
+	/** Draws, dispatches and copies recorded. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		int32 DrawCalls = 0;
+
+	/** Shader parameters, uniform buffers and geometry sent to the GPU. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		int64 UploadedBytes = 0;
+};
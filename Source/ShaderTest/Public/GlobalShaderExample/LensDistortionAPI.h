@@ -0,0 +1,244 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+//https://docs.unrealengine.com/5.0/en-US/creating-a-new-global-shader-as-a-plugin-in-unreal-engine/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LensDistortionAPI.generated.h"
+
+/** Direction of the lens distortion applied to an image. */
+UENUM(BlueprintType)
+enum class ELensDistortionApplyMode : uint8
+{
+    /** Warps the undistorted, overscanned render into the distorted image. */
+    Distort,
+
+    /** Warps the distorted image into the undistorted, overscanned, render. */
+    Undistort
+};
+
+struct FLensDistortionCamera;
+
+/** Mathematic camera model for lens distortion/undistortion.
+ *
+ * Camera matrix =
+ *  | F.X  0  C.x |
+ *  |  0  F.Y C.Y |
+ *  |  0   0   1  |
+ */
+USTRUCT(BlueprintType)
+struct SHADERTEST_API FFooCameraModel
+{
+    GENERATED_USTRUCT_BODY()
+        FFooCameraModel()
+    {
+        K1 = K2 = K3 = P1 = P2 = 0.f;
+        F = FVector2D(1.f, 1.f);
+        C = FVector2D(0.5f, 0.5f);
+    }
+
+    /** Radial parameter #1. */
+    UPROPERTY(Interp, EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera Model")
+        float K1;
+
+    /** Radial parameter #2. */
+    UPROPERTY(Interp, EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera Model")
+        float K2;
+
+    /** Radial parameter #3. */
+    UPROPERTY(Interp, EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera Model")
+        float K3;
+
+    /** Tangential parameter #1. */
+    UPROPERTY(Interp, EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera Model")
+        float P1;
+
+    /** Tangential parameter #2. */
+    UPROPERTY(Interp, EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera Model")
+        float P2;
+
+    /** Camera matrix's Fx and Fy. */
+    UPROPERTY(Interp, EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera Model")
+        FVector2D F;
+
+    /** Camera matrix's Cx and Cy. */
+    UPROPERTY(Interp, EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera Model")
+        FVector2D C;
+
+    /** Undistorts 3d vector (x, y, z=1.f) in the view space and returns (x', y', z'=1.f). */
+    FVector2D UndistortNormalizedViewPosition(FVector2D V) const;
+
+    /** Distorts 3d vector (x', y', z'=1.f) in the view space and returns (x, y, z=1.f), the inverse of UndistortNormalizedViewPosition().
+     * Solved with a fixed budget of Newton iterations.
+     */
+    FVector2D DistortNormalizedViewPosition(FVector2D V) const;
+
+    /** Batch version of UndistortNormalizedViewPosition(), evaluated in float 4 positions at a time, large batches spread across cores.
+     * OutPositions may alias InPositions.
+     */
+    void UndistortNormalizedViewPositions(TArrayView<const FVector2D> InPositions, TArrayView<FVector2D> OutPositions) const;
+
+    /** Batch version of DistortNormalizedViewPosition(), same evaluation as UndistortNormalizedViewPositions().
+     * @param NumIterations Newton iteration budget per position.
+     * @return Number of positions that did not converge, these are left at their last iterate.
+     */
+    int32 DistortNormalizedViewPositions(TArrayView<const FVector2D> InPositions, TArrayView<FVector2D> OutPositions, int32 NumIterations = 8) const;
+
+    /** Returns the overscan factor required for the undistort rendering to avoid unrendered distorted pixels.
+     * @param bPrecise Bounds the undistorted viewport from the whole distorted viewport border instead of 8 points
+     *        padded by 2%, giving the tightest overscan. Memoized per camera model, FOV and aspect ratio.
+     */
+    float GetUndistortOverscanFactor(
+        float DistortedHorizontalFOV,
+        float DistortedAspectRatio,
+        bool bPrecise = false) const;
+
+    /** Draws UV displacement map within the output render target.
+     * - Red & green channels hold the distortion displacement;
+     * - Blue & alpha channels hold the undistortion displacement.
+     * Two channel formats (RG16F, RG32F) hold the SingleDirection displacement in red & green, RG32_UINT holds both
+     * directions packed as halves, distortion in red and undistortion in green.
+     * @param World Current world to get the rendering settings from (such as feature level).
+     * @param DistortedHorizontalFOV The desired horizontal FOV in the distorted render.
+     * @param DistortedAspectRatio The desired aspect ratio of the distorted render.
+     * @param UndistortOverscanFactor The factor of the overscan for the undistorted render.
+     * @param OutputRenderTarget The render target to draw to. Don't necessarily need to have same resolution or aspect ratio as distorted render.
+     * @param OutputMultiply The multiplication factor applied on the displacement. On the 8 bit normalized formats,
+     *        <= 0 fits the displacements in [0, 1] with GetNormalizedUVDisplacementMultiplyAndAdd() instead.
+     * @param OutputAdd Value added to the multiplied displacement before storing the output render target.
+     * @param SingleDirection Displacement held by the two channel formats.
+     */
+    void DrawUVDisplacementToRenderTarget(
+        class UWorld* World,
+        float DistortedHorizontalFOV,
+        float DistortedAspectRatio,
+        float UndistortOverscanFactor,
+        class UTextureRenderTarget2D* OutputRenderTarget,
+        float OutputMultiply,
+        float OutputAdd,
+        ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort) const;
+
+    /** Draws the UV displacement map of a camera model animated every frame, such as by Sequencer, within the output render target.
+     * The next map is generated on async compute while the render target keeps the previous one, so the render target lags
+     * one draw behind while the camera model moves, and changes below r.ShaderTest.LensDistortion.AnimatedEpsilon are skipped.
+     * The first map of a render target is generated on the graphics pipe and shown by that same draw.
+     * Same parameters as DrawUVDisplacementToRenderTarget(), the output render target needs a UAV compatible pixel format.
+     */
+    void DrawAnimatedUVDisplacementToRenderTarget(
+        class UWorld* World,
+        float DistortedHorizontalFOV,
+        float DistortedAspectRatio,
+        float UndistortOverscanFactor,
+        class UTextureRenderTarget2D* OutputRenderTarget,
+        float OutputMultiply,
+        float OutputAdd,
+        ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort) const;
+
+    /** Draws the UV displacement maps of several cameras, such as the calibrated cameras of a rig, within the slices of the
+     * output render target array in a single compute dispatch, instead of one render command and pass per camera.
+     * Slice i holds the displacement map of Cameras[i], the slices past the cameras are left untouched.
+     * Same channels, OutputMultiply, OutputAdd and SingleDirection as DrawUVDisplacementToRenderTarget(), the output
+     * multiply and add are fitted per camera on the 8 bit normalized formats.
+     */
+    static void DrawUVDisplacementsToRenderTargetArray(
+        class UWorld* World,
+        TConstArrayView<FLensDistortionCamera> Cameras,
+        class UTextureRenderTarget2DArray* OutputRenderTarget,
+        float OutputMultiply,
+        float OutputAdd,
+        ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort);
+
+    /** Returns the output multiply and add fitting the displacements of this lens in [0, 1], for the 8 bit normalized
+     * render targets, from a coarse CPU displacement map padded by a few percents. 0.5 is no displacement.
+     */
+    void GetNormalizedUVDisplacementMultiplyAndAdd(
+        float DistortedHorizontalFOV,
+        float DistortedAspectRatio,
+        float UndistortOverscanFactor,
+        float& OutputMultiply,
+        float& OutputAdd) const;
+
+    /** Warps the input texture into the output render target with this lens distortion in a single pass,
+     * instead of sampling the scene with a displacement map in a material.
+     * @param DistortedHorizontalFOV The desired horizontal FOV in the distorted render.
+     * @param DistortedAspectRatio The desired aspect ratio of the distorted render.
+     * @param UndistortOverscanFactor The factor of the overscan for the undistorted render.
+     * @param InputTexture Undistorted render to distort, or distorted image to undistort.
+     * @param OutputRenderTarget The render target to draw to, pixels warped from out of the input are black.
+     * @param bUseDisplacementMap Reads the warp from the cached displacement map of the output resolution instead of
+     *        evaluating the lens per pixel, worth it for a static lens undistorting by Newton iterations.
+     */
+    void ApplyToRenderTarget(
+        class UWorld* World,
+        float DistortedHorizontalFOV,
+        float DistortedAspectRatio,
+        float UndistortOverscanFactor,
+        class UTexture* InputTexture,
+        class UTextureRenderTarget2D* OutputRenderTarget,
+        ELensDistortionApplyMode Mode,
+        bool bUseDisplacementMap = false) const;
+
+    /** Draws the same UV displacement map as DrawUVDisplacementToRenderTarget() on the CPU, no RHI is required.
+     * Rows are spread across the task graph workers, 4 pixels evaluated at a time.
+     * @param OutputResolution Resolution of the displacement map.
+     * @param OutDisplacementMap Top left originated, row major pixels.
+     */
+    void DrawUVDisplacementToBuffer(
+        float DistortedHorizontalFOV,
+        float DistortedAspectRatio,
+        float UndistortOverscanFactor,
+        FIntPoint OutputResolution,
+        TArray<FLinearColor>& OutDisplacementMap,
+        float OutputMultiply = 0.5f,
+        float OutputAdd = 0.5f) const;
+
+    void DrawUVDisplacementToBuffer(
+        float DistortedHorizontalFOV,
+        float DistortedAspectRatio,
+        float UndistortOverscanFactor,
+        FIntPoint OutputResolution,
+        TArray<class FFloat16Color>& OutDisplacementMap,
+        float OutputMultiply = 0.5f,
+        float OutputAdd = 0.5f) const;
+
+    /** Compare two lens distortion models and return whether they are equal. */
+    bool operator == (const FFooCameraModel& Other) const
+    {
+        return (
+            K1 == Other.K1 &&
+            K2 == Other.K2 &&
+            K3 == Other.K3 &&
+            P1 == Other.P1 &&
+            P2 == Other.P2 &&
+            F == Other.F &&
+            C == Other.C);
+    }
+
+    /** Compare two lens distortion models and return whether they are different. */
+    bool operator != (const FFooCameraModel& Other) const
+    {
+        return !(*this == Other);
+    }
+};
+
+/** Camera model with the distorted render it is drawn for, see FFooCameraModel::DrawUVDisplacementsToRenderTargetArray(). */
+USTRUCT(BlueprintType)
+struct FLensDistortionCamera
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera")
+        FFooCameraModel CameraModel;
+
+    /** The desired horizontal FOV in the distorted render, in radians. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera")
+        float DistortedHorizontalFOV = HALF_PI;
+
+    /** The desired aspect ratio of the distorted render. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera")
+        float DistortedAspectRatio = 16.f / 9.f;
+
+    /** The factor of the overscan for the undistorted render. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lens Distortion|Camera")
+        float UndistortOverscanFactor = 1.f;
+};
@@ -10,6 +10,8 @@
 #include "ShaderTestLibrary.generated.h"
 
 
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FShaderTestReadbackDelegate, bool, bSuccess, const TArray<FLinearColor>&, Pixels, FIntPoint, Size);
+
 UCLASS()
 class UShaderTestLibrary : public UBlueprintFunctionLibrary
 {
@@ -19,14 +21,61 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (DefaultToSelf = "WorldContextObject"))
 		static void FirstShaderDrawRenderTarget(UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget, FLinearColor MyColor, bool UsingRDG=false);
 
+	/** Fills every render target with its color from one render command (and one graph when UsingRDG), MyColors may hold a single color for all targets. */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (DefaultToSelf = "WorldContextObject"))
+		static void FirstShaderDrawRenderTargets(UObject* WorldContextObject, const TArray<UTextureRenderTarget2D*>& OutputRenderTargets, const TArray<FLinearColor>& MyColors, bool UsingRDG=false);
+
+
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+		static void DrawTestTextureShaderRenderTarget(AActor* ContextActor,
+			UTextureRenderTarget2D* RenderTarget,
+			FTestTextureShaderStructData StructData,
+			UTexture* Texture
+		);
+
+	/** Draws the sprites of Texture into the render target with one instanced draw, in order, the later ones on top.
+	 *  The pixels out of the sprites keep their content unless bClearRenderTarget, which clears them to the render target's ClearColor.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+		static void DrawTestTextureShaderSprites(AActor* ContextActor,
+			UTextureRenderTarget2D* RenderTarget,
+			const TArray<FTestTextureSpriteDesc>& Sprites,
+			UTexture* Texture,
+			bool bOutputSRGB = false,
+			bool bClearRenderTarget = true
+		);
+
+	/** DrawTestTextureShaderSprites() with a texture per sprite, picked by its TextureIndex, still in one pass and one draw.
+	 *  The textures are packed into a texture array cached across calls, a texture is only copied again once re-created,
+	 *  the render targets are copied on every call. They must share the same size, format and sRGB sampling,
+	 *  the array keeps the mips they have in common.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+		static void DrawTestTextureShaderSpritesFromTextures(AActor* ContextActor,
+			UTextureRenderTarget2D* RenderTarget,
+			const TArray<FTestTextureSpriteDesc>& Sprites,
+			const TArray<UTexture*>& Textures,
+			bool bOutputSRGB = false,
+			bool bClearRenderTarget = true
+		);
+
+	/** Draws the animated fractal at Time into a render target created with bCanCreateUAV.
+	 *  bProgressive draws the image over several frames, a few tiles per frame within r.ShaderTest.ComputeShader.ProgressiveBudgetMs,
+	 *  the time of an image is the one passed when its first tile is drawn.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (WorldContext = "WorldContextObject"))
+		static void MyComputerShaderDraw(const UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget, float Time, bool bProgressive = false);
+
+	/** Reads the render target back without stalling, once the GPU is done with the draws called before.
+	 *  OnReadback is called on the game thread a few frames later, bSuccess is false for the formats other than 8 bit and float RGBA.
+	 *  The 8 bit pixels are converted from sRGB only when the render target is sRGB.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+		static void ReadbackRenderTargetAsync(UTextureRenderTarget2D* RenderTarget, FShaderTestReadbackDelegate OnReadback);
 
-// 	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
-// 		static void DrawTestTextureShaderRenderTarget(AActor* ContextActor,  //�ܻ�ȡWorld��Actor
-// 			UTextureRenderTarget2D* RenderTarget,  //��ȾĿ��
-// 			FTestTextureShaderStructData StructData,          //��ɫ
-// 			UTexture* Texture                  //����
-// 		);
-// 
-// 	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
-// 		static void MyComputerShaderDraw(const UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget);
+	/** Game thread, render thread and GPU time, draw calls and uploaded bytes of every plugin entry point over the latest frame,
+	 *  the GPU times lag a few frames. Same values as `stat ShaderTest`.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+		static TArray<FShaderTestPassStats> GetShaderTestPassStats();
 };
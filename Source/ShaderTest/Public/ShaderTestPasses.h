@@ -0,0 +1,54 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHIDefinitions.h"
+#include "RenderGraphDefinitions.h"
+#include "Common/MyShaderTypes.h"
+#include "GlobalShaderExample/LensDistortionAPI.h"
+
+/**
+ * Render thread versions of the UShaderTestLibrary and FFooCameraModel entry points, adding their passes to the graph of
+ * the caller, such as a scene view extension, instead of going through a render command and the plugin's own graph.
+ *
+ * The output textures are written like the render targets of the game thread versions. Their final access is left to
+ * the caller's graph, and the passes are counted in `stat ShaderTest` with the other draws of the plugin.
+ */
+
+/** Fills OutputTexture with Color, FirstShaderDrawRenderTarget() with UsingRDG. */
+SHADERTEST_API void AddFirstShaderPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	FLinearColor Color);
+
+/** Draws InputTexture, which must be valid, into OutputTexture, tinted by the color slot of StructData, like DrawTestTextureShaderRenderTarget(). */
+SHADERTEST_API void AddTestTextureShaderPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	const FTestTextureShaderStructData& StructData,
+	FRDGTextureRef InputTexture);
+
+/** Draws the whole fractal at Time into OutputTexture, which needs UAV support, like MyComputerShaderDraw() without bProgressive. */
+SHADERTEST_API void AddMyComputeShaderPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	float Time);
+
+/** Draws the UV displacement map of the camera model into OutputTexture, like FFooCameraModel::DrawUVDisplacementToRenderTarget().
+ *  The map comes from the displacement cache, so a static lens is only generated once per resolution and format.
+ */
+SHADERTEST_API void AddLensDistortionDisplacementMapPass(
+	FRDGBuilder& GraphBuilder,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRDGTextureRef OutputTexture,
+	const FFooCameraModel& CameraModel,
+	float DistortedHorizontalFOV,
+	float DistortedAspectRatio,
+	float UndistortOverscanFactor,
+	float OutputMultiply = 0.5f,
+	float OutputAdd = 0.5f,
+	ELensDistortionApplyMode SingleDirection = ELensDistortionApplyMode::Distort);
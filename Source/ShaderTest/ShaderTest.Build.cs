@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class ShaderTest : ModuleRules
@@ -18,6 +19,8 @@ public class ShaderTest : ModuleRules
 		PrivateIncludePaths.AddRange(
 			new string[] {
 				// ... add other private include paths required here ...
+				// The post process pass inputs of the lens distortion scene view extension.
+				Path.Combine(GetModuleDirectory("Renderer"), "Private"),
 			}
 			);
 			
@@ -41,6 +44,8 @@ public class ShaderTest : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"ImageCore",
+				"Renderer",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	